@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+
+// An allocator interface shared by collections and StringBuilder.
+// A zeroed Allocator forwards to malloc, realloc and free, or to
+// aligned_alloc for alignments stricter than those of malloc.
+
+typedef struct AllocatorVTable AllocatorVTable;
+
+struct AllocatorVTable {
+    void *(*Allocate)(void *context, size_t size, size_t alignment);
+    void *(*Reallocate)(void *context, void *ptr, size_t oldSize, size_t newSize, size_t alignment);
+    void (*Free)(void *context, void *ptr, size_t size);
+};
+
+typedef struct Allocator Allocator;
+
+struct Allocator {
+    AllocatorVTable const *VTable;
+    void *Context;
+};
+
+#define Allocator_Default() ((Allocator) {0})
+
+#define ALLOCATOR__IsOverAligned(Alignment) ((Alignment) > alignof(max_align_t))
+
+// aligned_alloc requires the size to be a multiple of the alignment.
+static inline void *ALLOCATOR__AlignedAlloc(size_t size, size_t alignment) {
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static inline void *Allocator_Allocate(Allocator allocator, size_t size, size_t alignment) {
+    if (NULL == allocator.VTable) {
+        return ALLOCATOR__IsOverAligned(alignment) ? ALLOCATOR__AlignedAlloc(size, alignment) : malloc(size);
+    }
+
+    return allocator.VTable->Allocate(allocator.Context, size, alignment);
+}
+
+static inline void *Allocator_Reallocate(
+        Allocator allocator,
+        void *ptr,
+        size_t oldSize,
+        size_t newSize,
+        size_t alignment
+) {
+    if (NULL == allocator.VTable) {
+        if (false == ALLOCATOR__IsOverAligned(alignment)) {
+            return realloc(ptr, newSize);
+        }
+        // realloc may move the block to an address with weaker alignment.
+        void *newPtr = ALLOCATOR__AlignedAlloc(newSize, alignment);
+        if (NULL != newPtr && NULL != ptr) {
+            memcpy(newPtr, ptr, oldSize < newSize ? oldSize : newSize);
+            free(ptr);
+        }
+        return newPtr;
+    }
+
+    return allocator.VTable->Reallocate(allocator.Context, ptr, oldSize, newSize, alignment);
+}
+
+static inline void Allocator_Free(Allocator allocator, void *ptr, size_t size) {
+    if (NULL == allocator.VTable) {
+        free(ptr);
+        return;
+    }
+
+    allocator.VTable->Free(allocator.Context, ptr, size);
+}
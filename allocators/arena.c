@@ -3,50 +3,217 @@
 #include "call_checked.h"
 #include "arena.h"
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(ARENA_NO_VIRTUAL_MEMORY)
+#include <unistd.h>
+#include <sys/mman.h>
+#define ARENA_VIRTUAL_MEMORY
+#endif
+
+// Trace hooks may be defined at compile time, e.g. -DARENA_TRACE_REGION_NEW(Region,Capacity)=...
+// ARENA_TRACE enables the built-in hooks that log to stderr
+#ifdef ARENA_TRACE
+#ifndef ARENA_TRACE_REGION_NEW
+#define ARENA_TRACE_REGION_NEW(Region, Capacity)                            \
+    fprintf(                                                                \
+        stderr,                                                             \
+        "ArenaRegion_New - creating a region with capacity %zu bytes\n",    \
+        (size_t) (Capacity)                                                 \
+    )
+#endif
+#ifndef ARENA_TRACE_REGION_FREE
+#define ARENA_TRACE_REGION_FREE(Region, Size, Capacity)                                             \
+    fprintf(                                                                                        \
+        stderr,                                                                                     \
+        "ArenaRegion_Free - freeing a region with size=%zu bytes and capacity=%zu bytes\n",         \
+        (size_t) (Size), (size_t) (Capacity)                                                        \
+    )
+#endif
+#endif // ARENA_TRACE
+
+#ifndef ARENA_TRACE_REGION_NEW
+#define ARENA_TRACE_REGION_NEW(Region, Capacity)            ((void) 0)
+#endif
+
+#ifndef ARENA_TRACE_REGION_FREE
+#define ARENA_TRACE_REGION_FREE(Region, Size, Capacity)     ((void) 0)
+#endif
+
 struct ArenaRegion {
     ArenaRegion *Next;
 
     uint8_t *Current;
+    uint8_t *Committed;
     uint8_t *End;
 
+    bool Mapped;
+
     uint8_t Data[];
 };
 
-#define ARENA_REGION_DEFAULT_CAPACITY   ((size_t) (4 * 1024))
+#define ARENA_MAX(A, B)     \
+({                          \
+    __auto_type _a = (A);   \
+    __auto_type _b = (B);   \
+    _a > _b ? _a : _b;      \
+})
+
+#define ARENA_ALIGN(Ptr, Alignment)                                                 \
+({                                                                                  \
+    __auto_type _alignment = (Alignment);                                           \
+    (uint8_t *) (((intptr_t) (Ptr) + _alignment - 1) / _alignment * _alignment);    \
+})
+
+#define ARENA_ALIGN_SIZE(Size, Alignment)                                   \
+({                                                                          \
+    size_t _alignment_size = (Alignment);                                   \
+    ((Size) + _alignment_size - 1) / _alignment_size * _alignment_size;     \
+})
 
 ArenaRegion *ArenaRegion_New(size_t capacity, ArenaRegion *next) {
-    printf("ArenaRegion_New - creating a region with capacity %zu bytes\n", capacity);
-    ArenaRegion *region = CallChecked(calloc, (1, sizeof(ArenaRegion) + capacity));
+    ArenaRegion *region = CallChecked(malloc, (sizeof(ArenaRegion) + capacity));
     *region = (ArenaRegion) {
             .Current = region->Data,
+            .Committed = region->Data + capacity,
             .End = region->Data + capacity,
             .Next = next,
     };
 
+    ARENA_TRACE_REGION_NEW(region, capacity);
     return region;
 }
 
+#ifdef ARENA_VIRTUAL_MEMORY
+
+#define ARENA_COMMIT_GRANULARITY            ((size_t) (64 * 1024))
+#define ARENA_HUGE_PAGE_COMMIT_GRANULARITY  ((size_t) (2 * 1024 * 1024))
+
+static size_t ArenaRegion_CommitGranularity(bool hugePages) {
+    return hugePages ? ARENA_HUGE_PAGE_COMMIT_GRANULARITY : ARENA_COMMIT_GRANULARITY;
+}
+
+static void ArenaRegion_Commit(ArenaRegion region[static 1], uint8_t *until, bool hugePages) {
+    if (until <= region->Committed) {
+        return;
+    }
+
+    size_t const granularity = ArenaRegion_CommitGranularity(hugePages);
+    uint8_t *committed = ARENA_ALIGN(until, granularity);
+    if (committed > region->End) {
+        committed = region->End;
+    }
+
+    CallChecked(mprotect, (region->Committed, committed - region->Committed, PROT_READ | PROT_WRITE));
+    region->Committed = committed;
+}
+
+ArenaRegion *ArenaRegion_Reserve(size_t capacity, bool hugePages, ArenaRegion *next) {
+    size_t const granularity = ArenaRegion_CommitGranularity(hugePages);
+    size_t const size = ARENA_ALIGN_SIZE(sizeof(ArenaRegion) + capacity, granularity);
+
+    // Only huge-page-aligned ranges can be backed by huge pages, so in that mode reserve
+    // one extra granule, start the region at the first aligned address and unmap the slack
+    size_t const slack = hugePages ? granularity : 0;
+    uint8_t *const mapped = CallChecked(mmap, (NULL, size + slack, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    uint8_t *const address = hugePages ? ARENA_ALIGN(mapped, granularity) : mapped;
+    if (address > mapped) {
+        CallChecked(munmap, (mapped, address - mapped));
+    }
+    if (mapped + slack > address) {
+        CallChecked(munmap, (address + size, mapped + slack - address));
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugePages) {
+        madvise(address, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    ArenaRegion *region = (ArenaRegion *) address;
+    CallChecked(mprotect, (address, sizeof(ArenaRegion), PROT_READ | PROT_WRITE));
+    *region = (ArenaRegion) {
+            .Current = region->Data,
+            .Committed = ARENA_ALIGN(region->Data, (size_t) sysconf(_SC_PAGESIZE)),
+            .End = (uint8_t *) address + size,
+            .Mapped = true,
+            .Next = next,
+    };
+
+    ARENA_TRACE_REGION_NEW(region, region->End - region->Data);
+    return region;
+}
+
+static void ArenaRegion_Decommit(ArenaRegion region[static 1]) {
+    uint8_t *const start = ARENA_ALIGN(region->Data, (size_t) sysconf(_SC_PAGESIZE));
+    if (start < region->Committed) {
+        madvise(start, region->Committed - start, MADV_DONTNEED);
+    }
+}
+
+#endif // ARENA_VIRTUAL_MEMORY
+
 void ArenaRegion_Free(ArenaRegion *region) {
-    printf(
-            "ArenaRegion_Free - freeing a region with size=%td bytes and capacity=%td bytes\n",
-            region->Current - region->Data,
-            region->End - region->Data
-    );
+    ARENA_TRACE_REGION_FREE(region, region->Current - region->Data, region->End - region->Data);
+#ifdef ARENA_VIRTUAL_MEMORY
+    if (region->Mapped) {
+        CallChecked(munmap, (region, region->End - (uint8_t *) region));
+        return;
+    }
+#endif
     free(region);
 }
 
-#define ARENA_MAX(A, B)     \
-({                          \
-    __auto_type _a = (A);   \
-    __auto_type _b = (B);   \
-    _a > _b ? _a : _b;      \
-})
+static ArenaRegion *ArenaAllocator_TakeSpare(ArenaAllocator allocator[static 1], size_t capacity) {
+    for (ArenaRegion **it = &allocator->Spare; NULL != *it; it = &(*it)->Next) {
+        ArenaRegion *region = *it;
+        if ((size_t) (region->End - region->Data) < capacity) {
+            continue;
+        }
 
-#define ARENA_ALIGN(Ptr, Alignment)                                                 \
-({                                                                                  \
-    __auto_type _alignment = (Alignment);                                           \
-    (uint8_t *) (((intptr_t) (Ptr) + _alignment - 1) / _alignment * _alignment);    \
-})
+        *it = region->Next;
+        region->Current = region->Data;
+        return region;
+    }
+
+    return NULL;
+}
+
+static ArenaRegion *ArenaAllocator_NewRegion(ArenaAllocator allocator[static 1], size_t capacity, ArenaRegion *next) {
+    ArenaRegion *region = NULL;
+#ifdef ARENA_VIRTUAL_MEMORY
+    if (0 != allocator->ReserveCapacity) {
+        region = ArenaRegion_Reserve(ARENA_MAX(capacity, allocator->ReserveCapacity), allocator->HugePages, next);
+    }
+#endif
+    if (NULL == region) {
+        region = ArenaRegion_New(capacity, next);
+    }
+
+    allocator->Stats.Reserved += region->End - region->Data;
+    allocator->Stats.Regions++;
+    return region;
+}
+
+static size_t ArenaAllocator_NextRegionCapacity(ArenaAllocator allocator[static 1]) {
+    if (0 == allocator->InitialRegionCapacity) {
+        allocator->InitialRegionCapacity = ARENA_DEFAULT_INITIAL_REGION_CAPACITY;
+    }
+    if (0 == allocator->MaxRegionCapacity) {
+        allocator->MaxRegionCapacity = ARENA_DEFAULT_MAX_REGION_CAPACITY;
+    }
+    if (0 == allocator->GrowthFactor) {
+        allocator->GrowthFactor = ARENA_DEFAULT_GROWTH_FACTOR;
+    }
+    if (0 == allocator->NextRegionCapacity) {
+        allocator->NextRegionCapacity = allocator->InitialRegionCapacity;
+    }
+
+    size_t const capacity = allocator->NextRegionCapacity;
+    allocator->NextRegionCapacity =
+            capacity > allocator->MaxRegionCapacity / allocator->GrowthFactor
+            ? allocator->MaxRegionCapacity
+            : capacity * allocator->GrowthFactor;
+
+    return capacity;
+}
 
 void *Arena_Allocate(ArenaAllocator allocator[static 1], size_t size, size_t alignment) {
     if (0 == size) {
@@ -58,23 +225,215 @@ void *Arena_Allocate(ArenaAllocator allocator[static 1], size_t size, size_t ali
     }
 
     ArenaRegion *region = allocator->Region;
-    if (NULL == region || ARENA_ALIGN(region->Current, alignment) + size >= region->End) {
-        allocator->Region = region =
-                ArenaRegion_New(ARENA_MAX(size + alignment - 1, ARENA_REGION_DEFAULT_CAPACITY), region);
+    if (NULL == region || ARENA_ALIGN(region->Current, alignment) + size > region->End) {
+        if (NULL != region) {
+            allocator->Stats.TailWaste += region->End - region->Current;
+        }
+
+        size_t const capacity = size + alignment - 1;
+        ArenaRegion *spare = ArenaAllocator_TakeSpare(allocator, capacity);
+        if (NULL != spare) {
+            spare->Next = region;
+            allocator->Region = region = spare;
+        } else {
+            allocator->Region = region = ArenaAllocator_NewRegion(
+                    allocator,
+                    ARENA_MAX(capacity, ArenaAllocator_NextRegionCapacity(allocator)),
+                    region
+            );
+        }
     }
 
     uint8_t *const result = ARENA_ALIGN(region->Current, alignment);
+    allocator->Stats.Padding += result - region->Current;
+    allocator->Stats.Allocated += size;
     region->Current = result + size;
+
+    size_t const used = allocator->Stats.Allocated + allocator->Stats.Padding + allocator->Stats.TailWaste;
+    if (used > allocator->Stats.Peak) {
+        allocator->Stats.Peak = used;
+    }
+#ifdef ARENA_VIRTUAL_MEMORY
+    ArenaRegion_Commit(region, region->Current, allocator->HugePages);
+#endif
     return result;
 }
 
-void Arena_Free(ArenaAllocator allocator[1]) {
+void *Arena_AllocateZeroed(ArenaAllocator allocator[static 1], size_t size, size_t alignment) {
+    void *const result = Arena_Allocate(allocator, size, alignment);
+    if (NULL != result) {
+        memset(result, 0, size);
+    }
+
+    return result;
+}
+
+bool Arena_Extend(ArenaAllocator allocator[static 1], void *ptr, size_t oldSize, size_t newSize) {
     ArenaRegion *region = allocator->Region;
+    uint8_t *const start = ptr;
+    bool const isLast = NULL != region && NULL != start && start + oldSize == region->Current;
+
+    if (false == isLast) {
+        return newSize <= oldSize;
+    }
+
+    if (newSize > (size_t) (region->End - start)) {
+        return false;
+    }
+
+    region->Current = start + newSize;
+#ifdef ARENA_VIRTUAL_MEMORY
+    ArenaRegion_Commit(region, region->Current, allocator->HugePages);
+#endif
+
+    allocator->Stats.Allocated = allocator->Stats.Allocated - oldSize + newSize;
+    size_t const used = allocator->Stats.Allocated + allocator->Stats.Padding + allocator->Stats.TailWaste;
+    if (used > allocator->Stats.Peak) {
+        allocator->Stats.Peak = used;
+    }
+
+    return true;
+}
+
+void *Arena_Realloc(ArenaAllocator allocator[static 1], void *ptr, size_t oldSize, size_t newSize) {
+    if (NULL == ptr) {
+        return Arena_Allocate(allocator, newSize, alignof(max_align_t));
+    }
+
+    if (Arena_Extend(allocator, ptr, oldSize, newSize)) {
+        return 0 == newSize ? NULL : ptr;
+    }
+
+    uintptr_t const address = (uintptr_t) ptr;
+    size_t alignment = address & -address;
+    if (alignment > alignof(max_align_t)) {
+        alignment = alignof(max_align_t);
+    }
+
+    void *const result = Arena_Allocate(allocator, newSize, alignment);
+    memcpy(result, ptr, oldSize);
+    return result;
+}
+
+static void *ArenaAllocator_VTableAllocate(void *context, size_t size, size_t alignment) {
+    return Arena_Allocate(context, size, alignment);
+}
+
+static void *ArenaAllocator_VTableReallocate(
+        void *context,
+        void *ptr,
+        size_t oldSize,
+        size_t newSize,
+        size_t alignment
+) {
+    if (Arena_Extend(context, ptr, oldSize, newSize)) {
+        return 0 == newSize ? NULL : ptr;
+    }
+
+    void *const result = Arena_Allocate(context, newSize, alignment);
+    if (NULL != ptr) {
+        memcpy(result, ptr, oldSize);
+    }
+    return result;
+}
+
+static void ArenaAllocator_VTableFree(void *context, void *ptr, size_t size) {
+    Arena_Extend(context, ptr, size, 0);
+}
+
+static AllocatorVTable const ArenaAllocator_VTable = {
+        .Allocate = ArenaAllocator_VTableAllocate,
+        .Reallocate = ArenaAllocator_VTableReallocate,
+        .Free = ArenaAllocator_VTableFree,
+};
+
+Allocator Arena_Allocator(ArenaAllocator allocator[static 1]) {
+    return (Allocator) {
+            .VTable = &ArenaAllocator_VTable,
+            .Context = allocator,
+    };
+}
+
+static void ArenaRegion_FreeAll(ArenaRegion *region) {
     while (NULL != region) {
         ArenaRegion *next = region->Next;
         ArenaRegion_Free(region);
         region = next;
     }
+}
+
+void Arena_Free(ArenaAllocator allocator[1]) {
+    ArenaRegion_FreeAll(allocator->Region);
+    ArenaRegion_FreeAll(allocator->Spare);
+
+    allocator->Region = NULL;
+    allocator->Spare = NULL;
+    allocator->NextRegionCapacity = 0;
+    allocator->Stats = (ArenaStats) {0};
+}
+
+ArenaStats Arena_Stats(ArenaAllocator const allocator[static 1]) {
+    return allocator->Stats;
+}
+
+ArenaMark Arena_Mark(ArenaAllocator allocator[static 1]) {
+    ArenaRegion *region = allocator->Region;
+    return (ArenaMark) {
+            .Region = region,
+            .Current = NULL != region ? region->Current : NULL,
+            .Allocated = allocator->Stats.Allocated,
+            .Padding = allocator->Stats.Padding,
+            .TailWaste = allocator->Stats.TailWaste,
+    };
+}
+
+void Arena_Rewind(ArenaAllocator allocator[static 1], ArenaMark mark) {
+    while (allocator->Region != mark.Region && NULL != allocator->Region) {
+        ArenaRegion *region = allocator->Region;
+        allocator->Region = region->Next;
+        region->Next = allocator->Spare;
+        allocator->Spare = region;
+    }
+
+    if (NULL != allocator->Region) {
+        allocator->Region->Current = mark.Current;
+    }
+
+    allocator->Stats.Allocated = mark.Allocated;
+    allocator->Stats.Padding = mark.Padding;
+    allocator->Stats.TailWaste = mark.TailWaste;
+}
+
+void Arena_Reset(ArenaAllocator allocator[static 1], bool coalesce) {
+    Arena_Rewind(allocator, (ArenaMark) {0});
+
+#ifdef ARENA_VIRTUAL_MEMORY
+    if (allocator->DecommitOnReset) {
+        for (ArenaRegion *region = allocator->Spare; NULL != region; region = region->Next) {
+            if (region->Mapped) {
+                ArenaRegion_Decommit(region);
+            }
+        }
+    }
+#endif
+
+    if (false == coalesce || NULL == allocator->Spare || NULL == allocator->Spare->Next) {
+        return;
+    }
+
+    ArenaRegion_FreeAll(allocator->Spare);
+    allocator->Stats.Reserved = 0;
+    allocator->Stats.Regions = 0;
+    allocator->Spare = ArenaAllocator_NewRegion(allocator, allocator->Stats.Peak, NULL);
+}
+
+ArenaScope ArenaScope_Begin(ArenaAllocator allocator[static 1]) {
+    return (ArenaScope) {
+            .Allocator = allocator,
+            .Mark = Arena_Mark(allocator),
+    };
+}
 
-    *allocator = Arena_Empty();
+void ArenaScope_End(ArenaScope scope[static 1]) {
+    Arena_Rewind(scope->Allocator, scope->Mark);
 }
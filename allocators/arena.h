@@ -3,24 +3,134 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdalign.h>
 
+#include "allocator.h"
+
 // TODO limit size ana alignment to reasonable values to avoid possible overflow when calculating aligned addresses
 
 typedef struct ArenaRegion ArenaRegion;
 
+typedef struct ArenaStats ArenaStats;
+
+struct ArenaStats {
+    // Bytes requested by live allocations
+    size_t Allocated;
+    // Capacity of all regions, including spare ones
+    size_t Reserved;
+    size_t Regions;
+    // Bytes skipped to align allocations
+    size_t Padding;
+    // Bytes left unused at the end of a region when the next one was opened
+    size_t TailWaste;
+    // Highest value of Allocated + Padding + TailWaste so far
+    size_t Peak;
+};
+
 typedef struct ArenaAllocator ArenaAllocator;
 
 struct ArenaAllocator {
     ArenaRegion *Region;
+    ArenaRegion *Spare;
+
+    size_t InitialRegionCapacity;
+    size_t MaxRegionCapacity;
+    size_t GrowthFactor;
+    size_t NextRegionCapacity;
+
+    // When not 0, each region is a virtual address range of at least this many bytes,
+    // reserved up front and committed as allocations advance
+    size_t ReserveCapacity;
+    bool HugePages;
+    bool DecommitOnReset;
+
+    ArenaStats Stats;
 };
 
+typedef struct ArenaMark ArenaMark;
+
+struct ArenaMark {
+    ArenaRegion *Region;
+    uint8_t *Current;
+
+    size_t Allocated;
+    size_t Padding;
+    size_t TailWaste;
+};
+
+typedef struct ArenaScope ArenaScope;
+
+struct ArenaScope {
+    ArenaAllocator *Allocator;
+    ArenaMark Mark;
+    bool Done;
+};
+
+#define ARENA_DEFAULT_INITIAL_REGION_CAPACITY   ((size_t) (4 * 1024))
+#define ARENA_DEFAULT_MAX_REGION_CAPACITY       ((size_t) (64 * 1024 * 1024))
+#define ARENA_DEFAULT_GROWTH_FACTOR             ((size_t) 2)
+
 #define Arena_Empty()   ((ArenaAllocator) {0})
 
+// Zero arguments are replaced with the defaults above
+#define Arena_WithRegionCapacity(InitialCapacity, GrowthFactor_, MaxCapacity)   \
+((ArenaAllocator) {                                                             \
+    .InitialRegionCapacity = (InitialCapacity),                                 \
+    .GrowthFactor = (GrowthFactor_),                                            \
+    .MaxRegionCapacity = (MaxCapacity),                                         \
+})
+
+// Returned memory is not initialized
 void *Arena_Allocate(ArenaAllocator allocator[static 1], size_t size, size_t alignment);
 
+void *Arena_AllocateZeroed(ArenaAllocator allocator[static 1], size_t size, size_t alignment);
+
+// Resize the allocation at ptr in place. Only the most recent allocation can grow;
+// any allocation can "shrink" without moving
+bool Arena_Extend(ArenaAllocator allocator[static 1], void *ptr, size_t oldSize, size_t newSize);
+
+// Resize in place when possible, otherwise allocate and copy. The new block keeps the
+// alignment of ptr, up to alignof(max_align_t)
+void *Arena_Realloc(ArenaAllocator allocator[static 1], void *ptr, size_t oldSize, size_t newSize);
+
 void Arena_Free(ArenaAllocator allocator[static 1]);
 
+ArenaStats Arena_Stats(ArenaAllocator const allocator[static 1]);
+
+// An Allocator backed by the arena. Free only reclaims memory of the most recent allocation
+Allocator Arena_Allocator(ArenaAllocator allocator[static 1]);
+
+ArenaMark Arena_Mark(ArenaAllocator allocator[static 1]);
+
+void Arena_Rewind(ArenaAllocator allocator[static 1], ArenaMark mark);
+
+void Arena_Reset(ArenaAllocator allocator[static 1], bool coalesce);
+
+ArenaScope ArenaScope_Begin(ArenaAllocator allocator[static 1]);
+
+void ArenaScope_End(ArenaScope scope[static 1]);
+
+// Optional designated initializers set HugePages and DecommitOnReset, e.g.
+// Arena_Reserved(1ull << 32, .HugePages = true)
+#define Arena_Reserved(ReserveCapacity_, ...)   \
+((ArenaAllocator) {                             \
+    .ReserveCapacity = (ReserveCapacity_),      \
+    ##__VA_ARGS__                               \
+})
+
+#define ARENA__Concat_(A, B)    A ## B
+#define ARENA__Concat(A, B)     ARENA__Concat_(A, B)
+
+#define Arena_Scope(ArenaPtr)                                                       \
+for (                                                                               \
+    ArenaScope ARENA__Concat(_arena_scope_, __LINE__)                               \
+        __attribute__((cleanup(ArenaScope_End))) = ArenaScope_Begin(ArenaPtr);      \
+    false == ARENA__Concat(_arena_scope_, __LINE__).Done;                           \
+    ARENA__Concat(_arena_scope_, __LINE__).Done = true                              \
+)
+
 #define Arena_New(ArenaPtr, Type) (Type *) Arena_Allocate((ArenaPtr), sizeof(Type), alignof(Type));
 
 #define Arena_NewArray(ArenaPtr, Type, Count) (Type *) Arena_Allocate((ArenaPtr), (Count) * sizeof(Type), alignof(Type))
@@ -36,5 +146,3 @@ void Arena_Free(ArenaAllocator allocator[static 1]);
     memcpy(_p, (Src), _count);              \
     (typeof(Src)) _p;                       \
 })
-
-
@@ -18,17 +18,17 @@ int main(void) {
     A *b = Arena_Copy(&allocator, &((A) {.Int=33, .Str="amogus"}), sizeof(A));
     printf("%d %s\n", b->Int, b->Str);
 
-    int *nums = Arena_NewArray(&allocator, int, 100);
+    int *nums = Arena_AllocateZeroed(&allocator, sizeof(int) * 100, alignof(int));
     for (size_t i = 0; i < 100; i++) {
         printf("\r%d\r", nums[i]);
     }
 
-    int *nums1 = Arena_Allocate(&allocator, sizeof(int) * 250, alignof(int));
+    int *nums1 = Arena_AllocateZeroed(&allocator, sizeof(int) * 250, alignof(int));
     for (size_t i = 0; i < 250; i++) {
         printf("\r%d\r", nums1[i]);
     }
 
-    int *nums2 = Arena_Allocate(&allocator, sizeof(int) * 2000, alignof(int));
+    int *nums2 = Arena_AllocateZeroed(&allocator, sizeof(int) * 2000, alignof(int));
     for (size_t i = 0; i < 100; i++) {
         printf("\r%d\r", nums2[i]);
     }
@@ -0,0 +1,388 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "arena.h"
+#include "collections/vector.h"
+#include "collections/map.h"
+
+#define STRING_BUILDER_IMPLEMENTATION
+
+#include "strings/string_builder.h"
+
+#include "testing/testing.h"
+
+Testing_Fact(Allocate_returns_NULL_for_zero_size) {
+    ArenaAllocator sut = Arena_Empty();
+
+    Testing_Assert(NULL == Arena_Allocate(&sut, 0, 1), "expected NULL for zero size");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Allocate_returns_aligned_pointers) {
+    ArenaAllocator sut = Arena_Empty();
+
+    size_t const alignments[] = {1, 2, 4, 8, 16, 64, 256};
+    size_t const alignmentsCount = sizeof(alignments) / sizeof(alignments[0]);
+
+    for (size_t i = 0; i < alignmentsCount; i++) {
+        Arena_Allocate(&sut, 1, 1);
+        uintptr_t const p = (uintptr_t) Arena_Allocate(&sut, 3, alignments[i]);
+        Testing_Assert(0 == p % alignments[i], "expected pointer to be aligned to %zu", alignments[i]);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(AllocateZeroed_returns_zeroed_memory_after_rewind) {
+    ArenaAllocator sut = Arena_Empty();
+    ArenaMark const mark = Arena_Mark(&sut);
+
+    uint8_t *const dirty = Arena_Allocate(&sut, 256, 1);
+    memset(dirty, 0xFF, 256);
+    Arena_Rewind(&sut, mark);
+
+    uint8_t *const zeroed = Arena_AllocateZeroed(&sut, 256, 1);
+    for (size_t i = 0; i < 256; i++) {
+        Testing_Assert(0 == zeroed[i], "expected byte #%zu to be 0 but was %d", i, zeroed[i]);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Rewind_to_mark_reuses_memory_allocated_after_mark) {
+    ArenaAllocator sut = Arena_Empty();
+    Arena_Allocate(&sut, 16, 1);
+
+    ArenaMark const mark = Arena_Mark(&sut);
+    void *const first = Arena_Allocate(&sut, 32, 1);
+    Arena_Rewind(&sut, mark);
+    void *const second = Arena_Allocate(&sut, 32, 1);
+
+    Testing_Assert(first == second, "expected allocation after rewind to reuse memory");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Rewind_keeps_regions_allocated_after_mark) {
+    ArenaAllocator sut = Arena_Empty();
+    ArenaMark const mark = Arena_Mark(&sut);
+
+    void *before[8];
+    for (size_t i = 0; i < 8; i++) {
+        before[i] = Arena_Allocate(&sut, 3000, 8);
+    }
+    Arena_Rewind(&sut, mark);
+
+    for (size_t i = 0; i < 8; i++) {
+        void *const after = Arena_Allocate(&sut, 3000, 8);
+        Testing_Assert(before[i] == after, "expected allocation #%zu to reuse a kept region", i);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Scope_rewinds_arena_on_exit) {
+    ArenaAllocator sut = Arena_Empty();
+    Arena_Allocate(&sut, 16, 1);
+    ArenaMark const mark = Arena_Mark(&sut);
+
+    Arena_Scope(&sut) {
+        Arena_Allocate(&sut, 10000, 1);
+    }
+
+    ArenaMark const after = Arena_Mark(&sut);
+    Testing_Assert(mark.Region == after.Region, "expected region to be restored");
+    Testing_Assert(mark.Current == after.Current, "expected position to be restored");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Scope_rewinds_arena_on_break) {
+    ArenaAllocator sut = Arena_Empty();
+    Arena_Allocate(&sut, 16, 1);
+    ArenaMark const mark = Arena_Mark(&sut);
+
+    for (int i = 0; i < 3; i++) {
+        Arena_Scope(&sut) {
+            Arena_Allocate(&sut, 10000, 1);
+            break;
+        }
+    }
+
+    ArenaMark const after = Arena_Mark(&sut);
+    Testing_Assert(mark.Region == after.Region, "expected region to be restored");
+    Testing_Assert(mark.Current == after.Current, "expected position to be restored");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Reset_keeps_regions_for_reuse) {
+    ArenaAllocator sut = Arena_Empty();
+
+    void *const before = Arena_Allocate(&sut, 100, 1);
+    Arena_Allocate(&sut, 10000, 1);
+    Arena_Reset(&sut, false);
+    void *const after = Arena_Allocate(&sut, 100, 1);
+
+    Testing_Assert(before == after, "expected allocation after reset to reuse the first region");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Reset_with_coalesce_fits_previous_allocations_into_one_region) {
+    ArenaAllocator sut = Arena_Empty();
+
+    for (size_t i = 0; i < 16; i++) {
+        Arena_Allocate(&sut, 3000, 8);
+    }
+    Arena_Reset(&sut, true);
+
+    uint8_t *const first = Arena_Allocate(&sut, 3000, 8);
+    for (size_t i = 1; i < 16; i++) {
+        uint8_t *const p = Arena_Allocate(&sut, 3000, 8);
+        Testing_Assert(first + i * 3000 == p, "expected allocation #%zu to be contiguous with the first one", i);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Allocate_grows_region_capacity_geometrically_up_to_max) {
+    ArenaAllocator sut = Arena_WithRegionCapacity(1024, 2, 4096);
+
+    size_t const expectedCapacities[] = {2048, 4096, 4096, 4096};
+    size_t const expectedCount = sizeof(expectedCapacities) / sizeof(expectedCapacities[0]);
+
+    for (size_t i = 0; i < expectedCount; i++) {
+        Arena_Allocate(&sut, 1000, 1);
+        Testing_Assert(
+                expectedCapacities[i] == sut.NextRegionCapacity,
+                "expected next region capacity to be %zu but was %zu",
+                expectedCapacities[i], sut.NextRegionCapacity
+        );
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Free_keeps_region_capacity_settings) {
+    ArenaAllocator sut = Arena_WithRegionCapacity(1024, 3, 8192);
+    Arena_Allocate(&sut, 1, 1);
+
+    Arena_Free(&sut);
+
+    Testing_Assert(1024 == sut.InitialRegionCapacity, "expected initial capacity to be kept");
+    Testing_Assert(3 == sut.GrowthFactor, "expected growth factor to be kept");
+    Testing_Assert(8192 == sut.MaxRegionCapacity, "expected max capacity to be kept");
+    Testing_Assert(0 == sut.NextRegionCapacity, "expected next capacity to be reset");
+}
+
+Testing_Fact(Realloc_grows_last_allocation_in_place) {
+    ArenaAllocator sut = Arena_Empty();
+
+    Arena_Allocate(&sut, 16, 1);
+    uint8_t *const p = Arena_Allocate(&sut, 16, 1);
+    uint8_t *const grown = Arena_Realloc(&sut, p, 16, 1024);
+    uint8_t *const next = Arena_Allocate(&sut, 1, 1);
+
+    Testing_Assert(p == grown, "expected last allocation to grow in place");
+    Testing_Assert(p + 1024 == next, "expected next allocation to follow the grown block");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Realloc_copies_allocation_that_is_not_last) {
+    ArenaAllocator sut = Arena_Empty();
+
+    int *const p = Arena_NewArray(&sut, int, 4);
+    for (int i = 0; i < 4; i++) {
+        p[i] = i;
+    }
+    Arena_Allocate(&sut, 16, 1);
+
+    int *const grown = Arena_Realloc(&sut, p, 4 * sizeof(int), 8 * sizeof(int));
+
+    Testing_Assert(p != grown, "expected allocation to move");
+    Testing_Assert(0 == (uintptr_t) grown % alignof(int), "expected moved allocation to keep alignment");
+    for (int i = 0; i < 4; i++) {
+        Testing_Assert(i == grown[i], "expected value %d at index %d but got %d", i, i, grown[i]);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Extend_fails_for_allocation_that_is_not_last) {
+    ArenaAllocator sut = Arena_Empty();
+
+    void *const p = Arena_Allocate(&sut, 16, 1);
+    Arena_Allocate(&sut, 16, 1);
+
+    Testing_Assert(false == Arena_Extend(&sut, p, 16, 32), "expected Extend to fail");
+    Testing_Assert(true == Arena_Extend(&sut, p, 16, 8), "expected Extend to succeed when shrinking");
+
+    Arena_Free(&sut);
+}
+
+typedef Vector(int) IntVector;
+typedef Map(int, int) IntIntMap;
+
+static size_t IntHash(int value) { return (size_t) value; }
+
+static bool IntEquals(int a, int b) { return a == b; }
+
+Testing_Fact(Allocator_backs_vector_growth_in_place) {
+    ArenaAllocator arena = Arena_Empty();
+    IntVector sut = Vector_WithAllocator(IntVector, Arena_Allocator(&arena));
+
+    Vector_PushBack(&sut, 0);
+    int *const items = sut.Items;
+    for (int i = 1; i < 500; i++) {
+        Vector_PushBack(&sut, i);
+    }
+
+    Testing_Assert(items == sut.Items, "expected vector to grow in place inside the arena");
+    for (int i = 0; i < 500; i++) {
+        Testing_Assert(i == sut.Items[i], "expected value %d at index %d but got %d", i, i, sut.Items[i]);
+    }
+
+    Vector_Free(&sut);
+    Testing_Assert(NULL != sut.Allocator.VTable, "expected Free to keep the allocator");
+
+    Arena_Free(&arena);
+}
+
+Testing_Fact(Allocator_backs_map_and_string_builder) {
+    ArenaAllocator arena = Arena_Empty();
+    IntIntMap map = Map_WithAllocator(IntIntMap, IntHash, IntEquals, Arena_Allocator(&arena));
+    StringBuilder builder = StringBuilder_WithAllocator(Arena_Allocator(&arena));
+
+    for (int i = 0; i < 100; i++) {
+        Map_Put(&map, i, i * i);
+        StringBuilder_Sprintf(&builder, "%d", i % 10);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(i * i == Map_GetOrDefault(map, i, -1), "expected value %d at key %d", i * i, i);
+    }
+    Testing_Assert(100 == builder.CurrentLength, "expected 100 characters but got %zu", builder.CurrentLength);
+    Testing_Assert(0 == strncmp("0123456789", builder.Chars, 10), "expected digits in order");
+    Testing_Assert(0 != Arena_Stats(&arena).Allocated, "expected memory to come from the arena");
+
+    Map_Free(&map);
+    StringBuilder_Free(&builder);
+    Arena_Free(&arena);
+}
+
+Testing_Fact(Stats_track_allocated_padding_and_regions) {
+    ArenaAllocator sut = Arena_WithRegionCapacity(1024, 2, 0);
+
+    Arena_Allocate(&sut, 1, 1);
+    Arena_Allocate(&sut, 8, 8);
+    ArenaStats stats = Arena_Stats(&sut);
+
+    Testing_Assert(9 == stats.Allocated, "expected 9 bytes allocated but got %zu", stats.Allocated);
+    Testing_Assert(7 >= stats.Padding, "expected at most 7 bytes of padding but got %zu", stats.Padding);
+    Testing_Assert(1 == stats.Regions, "expected 1 region but got %zu", stats.Regions);
+    Testing_Assert(1024 == stats.Reserved, "expected 1024 bytes reserved but got %zu", stats.Reserved);
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Stats_track_tail_waste_when_opening_new_region) {
+    ArenaAllocator sut = Arena_WithRegionCapacity(1024, 2, 0);
+
+    Arena_Allocate(&sut, 1000, 1);
+    Arena_Allocate(&sut, 1000, 1);
+    ArenaStats const stats = Arena_Stats(&sut);
+
+    Testing_Assert(24 == stats.TailWaste, "expected 24 bytes of tail waste but got %zu", stats.TailWaste);
+    Testing_Assert(2 == stats.Regions, "expected 2 regions but got %zu", stats.Regions);
+    Testing_Assert(1024 + 2048 == stats.Reserved, "expected 3072 bytes reserved but got %zu", stats.Reserved);
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Stats_keep_peak_after_rewind) {
+    ArenaAllocator sut = Arena_Empty();
+    ArenaMark const mark = Arena_Mark(&sut);
+
+    Arena_Allocate(&sut, 100, 1);
+    Arena_Allocate(&sut, 200, 1);
+    Arena_Rewind(&sut, mark);
+    Arena_Allocate(&sut, 50, 1);
+    ArenaStats const stats = Arena_Stats(&sut);
+
+    Testing_Assert(50 == stats.Allocated, "expected 50 bytes allocated but got %zu", stats.Allocated);
+    Testing_Assert(300 == stats.Peak, "expected peak of 300 bytes but got %zu", stats.Peak);
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Reserved_arena_keeps_allocations_contiguous) {
+    ArenaAllocator sut = Arena_Reserved((size_t) 1 << 30);
+
+    size_t const size = 1024 * 1024;
+    uint8_t *const first = Arena_Allocate(&sut, size, 1);
+    memset(first, 0xAB, size);
+    for (size_t i = 1; i < 64; i++) {
+        uint8_t *const p = Arena_Allocate(&sut, size, 1);
+        Testing_Assert(first + i * size == p, "expected allocation #%zu to be contiguous with the first one", i);
+        memset(p, 0xAB, size);
+    }
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Reserved_arena_reuses_range_after_reset_with_decommit) {
+    ArenaAllocator sut = Arena_Reserved((size_t) 1 << 30, .DecommitOnReset = true);
+
+    size_t const size = 8 * 1024 * 1024;
+    uint8_t *const before = Arena_Allocate(&sut, size, 1);
+    memset(before, 0xAB, size);
+    Arena_Reset(&sut, false);
+    uint8_t *const after = Arena_Allocate(&sut, size, 1);
+    memset(after, 0xCD, size);
+
+    Testing_Assert(before == after, "expected allocation after reset to reuse the reserved range");
+
+    Arena_Free(&sut);
+}
+
+Testing_Fact(Reserved_arena_with_huge_pages_starts_regions_on_huge_page_boundary) {
+    ArenaAllocator sut = Arena_Reserved((size_t) 8 * 1024 * 1024, .HugePages = true);
+
+    uint8_t *const p = Arena_Allocate(&sut, 1024, 1);
+    memset(p, 0xAB, 1024);
+    size_t const hugePageSize = (size_t) 2 * 1024 * 1024;
+    Testing_Assert(0 == (uintptr_t) sut.Region % hugePageSize, "expected region to be aligned to %zu bytes", hugePageSize);
+
+    Arena_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Allocate_returns_NULL_for_zero_size),
+        Testing_AddTest(Allocate_returns_aligned_pointers),
+        Testing_AddTest(AllocateZeroed_returns_zeroed_memory_after_rewind),
+        Testing_AddTest(Rewind_to_mark_reuses_memory_allocated_after_mark),
+        Testing_AddTest(Rewind_keeps_regions_allocated_after_mark),
+        Testing_AddTest(Scope_rewinds_arena_on_exit),
+        Testing_AddTest(Scope_rewinds_arena_on_break),
+        Testing_AddTest(Allocate_grows_region_capacity_geometrically_up_to_max),
+        Testing_AddTest(Free_keeps_region_capacity_settings),
+        Testing_AddTest(Reset_keeps_regions_for_reuse),
+        Testing_AddTest(Reset_with_coalesce_fits_previous_allocations_into_one_region),
+        Testing_AddTest(Realloc_grows_last_allocation_in_place),
+        Testing_AddTest(Realloc_copies_allocation_that_is_not_last),
+        Testing_AddTest(Extend_fails_for_allocation_that_is_not_last),
+        Testing_AddTest(Allocator_backs_vector_growth_in_place),
+        Testing_AddTest(Allocator_backs_map_and_string_builder),
+        Testing_AddTest(Stats_track_allocated_padding_and_regions),
+        Testing_AddTest(Stats_track_tail_waste_when_opening_new_region),
+        Testing_AddTest(Stats_keep_peak_after_rewind),
+        Testing_AddTest(Reserved_arena_keeps_allocations_contiguous),
+        Testing_AddTest(Reserved_arena_reuses_range_after_reset_with_decommit),
+        Testing_AddTest(Reserved_arena_with_huge_pages_starts_regions_on_huge_page_boundary),
+};
+
+Testing_RunAllTests();
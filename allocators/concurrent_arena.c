@@ -0,0 +1,124 @@
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "call_checked.h"
+#include "concurrent_arena.h"
+
+struct ConcurrentArenaBlock {
+    ConcurrentArenaBlock *Next;
+
+    _Atomic size_t Used;
+    size_t Capacity;
+
+    alignas(max_align_t) uint8_t Data[];
+};
+
+#define CONCURRENT_ARENA_ALIGN(Ptr, Alignment)                                      \
+({                                                                                  \
+    __auto_type _alignment = (Alignment);                                           \
+    (uint8_t *) (((intptr_t) (Ptr) + _alignment - 1) / _alignment * _alignment);    \
+})
+
+static ConcurrentArenaBlock *ConcurrentArenaBlock_New(size_t capacity, size_t used, ConcurrentArenaBlock *next) {
+    ConcurrentArenaBlock *block = CallChecked(malloc, (sizeof(ConcurrentArenaBlock) + capacity));
+    block->Next = next;
+    block->Capacity = capacity;
+    atomic_init(&block->Used, used);
+    return block;
+}
+
+static void ConcurrentArenaBlock_FreeAll(ConcurrentArenaBlock *block) {
+    while (NULL != block) {
+        ConcurrentArenaBlock *next = block->Next;
+        free(block);
+        block = next;
+    }
+}
+
+static size_t ConcurrentArena_ChunkCapacity(ConcurrentArena const arena[static 1]) {
+    size_t const capacity = 0 != arena->ChunkCapacity
+                            ? arena->ChunkCapacity
+                            : CONCURRENT_ARENA_DEFAULT_CHUNK_CAPACITY;
+    return (capacity + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t);
+}
+
+static size_t ConcurrentArena_BlockCapacity(ConcurrentArena const arena[static 1], size_t chunkCapacity) {
+    size_t const capacity = 0 != arena->BlockCapacity
+                            ? arena->BlockCapacity
+                            : CONCURRENT_ARENA_DEFAULT_BLOCK_CAPACITY;
+    return capacity > chunkCapacity ? capacity : chunkCapacity;
+}
+
+static void *ConcurrentArena_AllocateLarge(ConcurrentArena arena[static 1], size_t size) {
+    ConcurrentArenaBlock *head = atomic_load_explicit(&arena->Large, memory_order_relaxed);
+    ConcurrentArenaBlock *block = ConcurrentArenaBlock_New(size, size, head);
+    while (false == atomic_compare_exchange_weak_explicit(
+            &arena->Large, &block->Next, block,
+            memory_order_release, memory_order_relaxed
+    )) {}
+
+    return block->Data;
+}
+
+static uint8_t *ConcurrentArena_TakeChunk(ConcurrentArena arena[static 1], size_t chunkCapacity) {
+    ConcurrentArenaBlock *block = atomic_load_explicit(&arena->Block, memory_order_acquire);
+    for (;;) {
+        if (NULL != block) {
+            size_t const offset = atomic_fetch_add_explicit(&block->Used, chunkCapacity, memory_order_relaxed);
+            if (offset <= block->Capacity - chunkCapacity) {
+                return block->Data + offset;
+            }
+        }
+
+        size_t const blockCapacity = ConcurrentArena_BlockCapacity(arena, chunkCapacity);
+        ConcurrentArenaBlock *fresh = ConcurrentArenaBlock_New(blockCapacity, chunkCapacity, block);
+        if (atomic_compare_exchange_strong_explicit(
+                &arena->Block, &block, fresh,
+                memory_order_acq_rel, memory_order_acquire
+        )) {
+            return fresh->Data;
+        }
+
+        // Another thread installed a block first, block now points to it
+        free(fresh);
+    }
+}
+
+ConcurrentArenaCache ConcurrentArena_Cache(ConcurrentArena arena[static 1]) {
+    return (ConcurrentArenaCache) {.Arena = arena};
+}
+
+void *ConcurrentArena_Allocate(ConcurrentArenaCache cache[static 1], size_t size, size_t alignment) {
+    if (0 == size) {
+        return NULL;
+    }
+
+    if (0 == alignment) {
+        alignment = 1;
+    }
+
+    uint8_t *result = CONCURRENT_ARENA_ALIGN(cache->Current, alignment);
+    if (NULL != cache->Current && result + size <= cache->End) {
+        cache->Current = result + size;
+        return result;
+    }
+
+    size_t const chunkCapacity = ConcurrentArena_ChunkCapacity(cache->Arena);
+    size_t const required = size + alignment - 1;
+    // Large requests get a dedicated block so they do not waste the rest of a chunk
+    if (required > chunkCapacity / 4) {
+        return CONCURRENT_ARENA_ALIGN(ConcurrentArena_AllocateLarge(cache->Arena, required), alignment);
+    }
+
+    cache->Current = ConcurrentArena_TakeChunk(cache->Arena, chunkCapacity);
+    cache->End = cache->Current + chunkCapacity;
+
+    result = CONCURRENT_ARENA_ALIGN(cache->Current, alignment);
+    cache->Current = result + size;
+    return result;
+}
+
+void ConcurrentArena_Free(ConcurrentArena arena[static 1]) {
+    ConcurrentArenaBlock_FreeAll(atomic_exchange(&arena->Block, NULL));
+    ConcurrentArenaBlock_FreeAll(atomic_exchange(&arena->Large, NULL));
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdalign.h>
+
+// An arena shared by several threads. Each thread allocates through its own
+// ConcurrentArenaCache, bumping a pointer inside a private chunk without locks.
+// Chunks are carved out of shared blocks with atomic operations only.
+//
+// ConcurrentArena_Free releases everything at once and must not run concurrently
+// with allocations.
+
+typedef struct ConcurrentArenaBlock ConcurrentArenaBlock;
+
+typedef struct ConcurrentArena ConcurrentArena;
+
+struct ConcurrentArena {
+    ConcurrentArenaBlock *_Atomic Block;
+    ConcurrentArenaBlock *_Atomic Large;
+
+    size_t ChunkCapacity;
+    size_t BlockCapacity;
+};
+
+typedef struct ConcurrentArenaCache ConcurrentArenaCache;
+
+struct ConcurrentArenaCache {
+    ConcurrentArena *Arena;
+
+    uint8_t *Current;
+    uint8_t *End;
+};
+
+#define CONCURRENT_ARENA_DEFAULT_CHUNK_CAPACITY ((size_t) (64 * 1024))
+#define CONCURRENT_ARENA_DEFAULT_BLOCK_CAPACITY ((size_t) (4 * 1024 * 1024))
+
+#define ConcurrentArena_Empty() ((ConcurrentArena) {0})
+
+// Zero arguments are replaced with the defaults above
+#define ConcurrentArena_WithCapacity(ChunkCapacity_, BlockCapacity_)    \
+((ConcurrentArena) {                                                    \
+    .ChunkCapacity = (ChunkCapacity_),                                  \
+    .BlockCapacity = (BlockCapacity_),                                  \
+})
+
+ConcurrentArenaCache ConcurrentArena_Cache(ConcurrentArena arena[static 1]);
+
+void *ConcurrentArena_Allocate(ConcurrentArenaCache cache[static 1], size_t size, size_t alignment);
+
+void ConcurrentArena_Free(ConcurrentArena arena[static 1]);
+
+#define ConcurrentArena_New(CachePtr, Type) \
+    (Type *) ConcurrentArena_Allocate((CachePtr), sizeof(Type), alignof(Type))
+
+#define ConcurrentArena_NewArray(CachePtr, Type, Count) \
+    (Type *) ConcurrentArena_Allocate((CachePtr), (Count) * sizeof(Type), alignof(Type))
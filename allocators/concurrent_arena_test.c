@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "concurrent_arena.h"
+
+#include "testing/testing.h"
+
+#define THREADS_COUNT       8
+#define ALLOCATIONS_COUNT   20000
+
+typedef struct Worker Worker;
+struct Worker {
+    ConcurrentArena *Arena;
+    uint8_t Tag;
+    uint8_t *Allocations[ALLOCATIONS_COUNT];
+    size_t Sizes[ALLOCATIONS_COUNT];
+};
+
+static void *Worker_Run(void *arg) {
+    Worker *worker = arg;
+    ConcurrentArenaCache cache = ConcurrentArena_Cache(worker->Arena);
+
+    for (size_t i = 0; i < ALLOCATIONS_COUNT; i++) {
+        size_t const size = 1 + (i * 7919 + worker->Tag) % (i % 100 == 0 ? 40000 : 200);
+        uint8_t *p = ConcurrentArena_Allocate(&cache, size, 8);
+        memset(p, worker->Tag, size);
+        worker->Allocations[i] = p;
+        worker->Sizes[i] = size;
+    }
+
+    return NULL;
+}
+
+Testing_Fact(Allocate_from_many_threads_returns_disjoint_memory) {
+    ConcurrentArena sut = ConcurrentArena_WithCapacity(4096, 64 * 1024);
+
+    static Worker workers[THREADS_COUNT];
+    pthread_t threads[THREADS_COUNT];
+    for (size_t i = 0; i < THREADS_COUNT; i++) {
+        workers[i] = (Worker) {.Arena = &sut, .Tag = (uint8_t) (i + 1)};
+        pthread_create(&threads[i], NULL, Worker_Run, &workers[i]);
+    }
+    for (size_t i = 0; i < THREADS_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (size_t i = 0; i < THREADS_COUNT; i++) {
+        for (size_t j = 0; j < ALLOCATIONS_COUNT; j++) {
+            uint8_t const *p = workers[i].Allocations[j];
+            Testing_Assert(0 == (uintptr_t) p % 8, "expected allocation to be aligned");
+            for (size_t k = 0; k < workers[i].Sizes[j]; k++) {
+                Testing_Assert(
+                        workers[i].Tag == p[k],
+                        "expected allocation #%zu of thread #%zu to not be overwritten", j, i
+                );
+            }
+        }
+    }
+
+    ConcurrentArena_Free(&sut);
+}
+
+Testing_Fact(Allocate_returns_NULL_for_zero_size) {
+    ConcurrentArena sut = ConcurrentArena_Empty();
+    ConcurrentArenaCache cache = ConcurrentArena_Cache(&sut);
+
+    Testing_Assert(NULL == ConcurrentArena_Allocate(&cache, 0, 1), "expected NULL for zero size");
+
+    ConcurrentArena_Free(&sut);
+}
+
+Testing_Fact(Free_allows_arena_to_be_reused) {
+    ConcurrentArena sut = ConcurrentArena_Empty();
+    ConcurrentArenaCache cache = ConcurrentArena_Cache(&sut);
+    ConcurrentArena_NewArray(&cache, int, 1000);
+    ConcurrentArena_Free(&sut);
+
+    cache = ConcurrentArena_Cache(&sut);
+    int *nums = ConcurrentArena_NewArray(&cache, int, 1000);
+    nums[999] = 42;
+
+    Testing_Assert(42 == nums[999], "expected arena to be usable after Free");
+
+    ConcurrentArena_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Allocate_from_many_threads_returns_disjoint_memory),
+        Testing_AddTest(Allocate_returns_NULL_for_zero_size),
+        Testing_AddTest(Free_allows_arena_to_be_reused),
+};
+
+Testing_RunAllTests();
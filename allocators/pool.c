@@ -0,0 +1,137 @@
+#include <errno.h>
+#include <stddef.h>
+
+#include "call_checked.h"
+#include "pool.h"
+
+struct PoolChunk {
+    PoolChunk *Next;
+
+    alignas(max_align_t) uint8_t Data[];
+};
+
+#define POOL_MAX(A, B)      \
+({                          \
+    __auto_type _a = (A);   \
+    __auto_type _b = (B);   \
+    _a > _b ? _a : _b;      \
+})
+
+#define POOL_ALIGN(Ptr, Alignment)                                                  \
+({                                                                                  \
+    __auto_type _alignment = (Alignment);                                           \
+    (uint8_t *) (((intptr_t) (Ptr) + _alignment - 1) / _alignment * _alignment);    \
+})
+
+static size_t PoolAllocator_Alignment(PoolAllocator const pool[static 1]) {
+    return POOL_MAX(pool->Alignment, alignof(void *));
+}
+
+// Every free slot has to hold a free list link
+static size_t PoolAllocator_SlotSize(PoolAllocator const pool[static 1]) {
+    size_t const alignment = PoolAllocator_Alignment(pool);
+    size_t const size = POOL_MAX(pool->ObjectSize, sizeof(void *));
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static void PoolAllocator_NewChunk(PoolAllocator pool[static 1], size_t slotSize) {
+    size_t objectsCount = pool->ObjectsPerChunk;
+    if (0 == objectsCount) {
+        objectsCount = POOL_MAX(POOL_DEFAULT_CHUNK_CAPACITY / slotSize, (size_t) 1);
+    }
+
+    size_t const alignment = PoolAllocator_Alignment(pool);
+    size_t const capacity = objectsCount * slotSize + alignment - 1;
+    PoolChunk *chunk = CallChecked(malloc, (sizeof(PoolChunk) + capacity));
+    chunk->Next = pool->Chunks;
+    pool->Chunks = chunk;
+
+    pool->Current = POOL_ALIGN(chunk->Data, alignment);
+    pool->End = pool->Current + objectsCount * slotSize;
+}
+
+void *Pool_Allocate(PoolAllocator pool[static 1]) {
+    if (NULL != pool->FreeList) {
+        void *object = pool->FreeList;
+        pool->FreeList = *(void **) object;
+        return object;
+    }
+
+    size_t const slotSize = PoolAllocator_SlotSize(pool);
+    if (NULL == pool->Current || pool->Current + slotSize > pool->End) {
+        PoolAllocator_NewChunk(pool, slotSize);
+    }
+
+    void *object = pool->Current;
+    pool->Current += slotSize;
+    return object;
+}
+
+void Pool_Release(PoolAllocator pool[static 1], void *object) {
+    if (NULL == object) {
+        return;
+    }
+
+    *(void **) object = pool->FreeList;
+    pool->FreeList = object;
+}
+
+void Pool_Free(PoolAllocator pool[static 1]) {
+    PoolChunk *chunk = pool->Chunks;
+    while (NULL != chunk) {
+        PoolChunk *next = chunk->Next;
+        free(chunk);
+        chunk = next;
+    }
+
+    *pool = Pool_Empty(pool->ObjectSize, pool->Alignment, pool->ObjectsPerChunk);
+}
+
+static void *PoolAllocator_VTableAllocate(void *context, size_t size, size_t alignment) {
+    PoolAllocator *pool = context;
+    if (size > pool->ObjectSize || alignment > PoolAllocator_Alignment(pool)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return Pool_Allocate(pool);
+}
+
+static void *PoolAllocator_VTableReallocate(
+        void *context,
+        void *ptr,
+        size_t oldSize,
+        size_t newSize,
+        size_t alignment
+) {
+    (void) oldSize;
+    if (NULL == ptr) {
+        return PoolAllocator_VTableAllocate(context, newSize, alignment);
+    }
+
+    PoolAllocator *pool = context;
+    if (newSize > pool->ObjectSize) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return ptr;
+}
+
+static void PoolAllocator_VTableFree(void *context, void *ptr, size_t size) {
+    (void) size;
+    Pool_Release(context, ptr);
+}
+
+static AllocatorVTable const PoolAllocator_VTable = {
+        .Allocate = PoolAllocator_VTableAllocate,
+        .Reallocate = PoolAllocator_VTableReallocate,
+        .Free = PoolAllocator_VTableFree,
+};
+
+Allocator Pool_Allocator(PoolAllocator pool[static 1]) {
+    return (Allocator) {
+            .VTable = &PoolAllocator_VTable,
+            .Context = pool,
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdalign.h>
+
+#include "allocator.h"
+
+// A fixed-size object allocator. Objects are carved out of large chunks and
+// released objects are kept in an intrusive free list, so both Pool_Allocate
+// and Pool_Release are O(1).
+
+typedef struct PoolChunk PoolChunk;
+
+typedef struct PoolAllocator PoolAllocator;
+
+struct PoolAllocator {
+    size_t ObjectSize;
+    size_t Alignment;
+    size_t ObjectsPerChunk;
+
+    PoolChunk *Chunks;
+    void *FreeList;
+
+    uint8_t *Current;
+    uint8_t *End;
+};
+
+#define POOL_DEFAULT_CHUNK_CAPACITY ((size_t) (64 * 1024))
+
+// ObjectsPerChunk_ may be 0 to fit chunks into POOL_DEFAULT_CHUNK_CAPACITY bytes
+#define Pool_Empty(ObjectSize_, Alignment_, ObjectsPerChunk_)   \
+((PoolAllocator) {                                              \
+    .ObjectSize = (ObjectSize_),                                \
+    .Alignment = (Alignment_),                                  \
+    .ObjectsPerChunk = (ObjectsPerChunk_),                      \
+})
+
+#define Pool_Of(Type) Pool_Empty(sizeof(Type), alignof(Type), 0)
+
+void *Pool_Allocate(PoolAllocator pool[static 1]);
+
+void Pool_Release(PoolAllocator pool[static 1], void *object);
+
+void Pool_Free(PoolAllocator pool[static 1]);
+
+// An Allocator backed by the pool. Requests larger than ObjectSize fail with ENOMEM
+Allocator Pool_Allocator(PoolAllocator pool[static 1]);
+
+#define Pool_New(PoolPtr, Type) (Type *) Pool_Allocate(PoolPtr)
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "pool.h"
+#include "collections/list.h"
+
+#include "testing/testing.h"
+
+typedef struct Node Node;
+struct Node {
+    int Value;
+    Node *Next;
+};
+
+typedef struct Aligned Aligned;
+struct Aligned {
+    alignas(64) char Bytes[3];
+};
+
+Testing_Fact(Allocate_returns_distinct_aligned_objects) {
+    PoolAllocator sut = Pool_Of(Aligned);
+
+    Aligned *objects[100];
+    for (size_t i = 0; i < 100; i++) {
+        objects[i] = Pool_New(&sut, Aligned);
+        Testing_Assert(0 == (uintptr_t) objects[i] % alignof(Aligned), "expected object #%zu to be aligned", i);
+        for (size_t j = 0; j < i; j++) {
+            Testing_Assert(objects[i] != objects[j], "expected objects #%zu and #%zu to be distinct", i, j);
+        }
+    }
+
+    Pool_Free(&sut);
+}
+
+Testing_Fact(Allocate_reuses_released_objects) {
+    PoolAllocator sut = Pool_Of(Node);
+
+    Node *const first = Pool_New(&sut, Node);
+    Pool_New(&sut, Node);
+    Pool_Release(&sut, first);
+    Node *const reused = Pool_New(&sut, Node);
+
+    Testing_Assert(first == reused, "expected released object to be reused");
+
+    Pool_Free(&sut);
+}
+
+Testing_Fact(Allocate_opens_new_chunks_when_chunk_is_full) {
+    PoolAllocator sut = Pool_Empty(sizeof(Node), alignof(Node), 4);
+
+    Node *nodes[10];
+    for (int i = 0; i < 10; i++) {
+        nodes[i] = Pool_New(&sut, Node);
+        *nodes[i] = (Node) {.Value = i};
+    }
+
+    for (int i = 0; i < 10; i++) {
+        Testing_Assert(i == nodes[i]->Value, "expected value %d but got %d", i, nodes[i]->Value);
+    }
+
+    Pool_Free(&sut);
+}
+
+Testing_Fact(Allocate_supports_objects_smaller_than_a_pointer) {
+    PoolAllocator sut = Pool_Of(char);
+
+    char *const a = Pool_New(&sut, char);
+    char *const b = Pool_New(&sut, char);
+    Pool_Release(&sut, a);
+    Pool_Release(&sut, b);
+
+    Testing_Assert(b == Pool_New(&sut, char), "expected last released object to be reused first");
+    Testing_Assert(a == Pool_New(&sut, char), "expected first released object to be reused last");
+
+    Pool_Free(&sut);
+}
+
+typedef List(int) IntsList;
+
+Testing_Fact(Allocator_backs_list_nodes) {
+    IntsList probe = List_Empty(IntsList);
+    PoolAllocator pool = Pool_Of(typeof(*probe.Head));
+    IntsList sut = List_WithAllocator(IntsList, Pool_Allocator(&pool));
+
+    for (int i = 0; i < 10; i++) {
+        List_PushBack(&sut, i);
+    }
+    void *const released = sut.Head;
+    List_TryPopFront(&sut, NULL);
+    List_PushBack(&sut, 10);
+
+    Testing_Assert(released == sut.Tail, "expected popped node to be reused for the next push");
+    int expected = 1;
+    List_ForEach(it, sut) {
+        Testing_Assert(expected == *it, "expected %d but got %d", expected, *it);
+        expected++;
+    }
+
+    List_Free(&sut);
+    Pool_Free(&pool);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Allocate_returns_distinct_aligned_objects),
+        Testing_AddTest(Allocate_reuses_released_objects),
+        Testing_AddTest(Allocate_opens_new_chunks_when_chunk_is_full),
+        Testing_AddTest(Allocate_supports_objects_smaller_than_a_pointer),
+        Testing_AddTest(Allocator_backs_list_nodes),
+};
+
+Testing_RunAllTests();
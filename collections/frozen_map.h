@@ -0,0 +1,339 @@
+#ifndef FROZEN_MAP_H
+#define FROZEN_MAP_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
+#include "hash.h"
+#include "map.h"
+
+// An immutable map built from a Map with a minimal perfect hash, using the
+// hash-and-displace (CHD) scheme. Keys are grouped into buckets by their
+// hash, and every bucket has a displacement that sends its keys to
+// distinct slots of a dense entry array with exactly Size entries.
+//
+// A lookup hashes the key once, reads the displacement of its bucket,
+// computes the slot, and compares that single entry's key. Buckets that
+// hold a single key store its slot directly, encoded as a negative
+// displacement, so their keys need no second mix.
+
+#define FROZEN_MAP__CallChecked(Callee, ArgsList)   \
+({                                                  \
+    errno = 0;                                      \
+    __auto_type _r = Callee ArgsList;               \
+    if (errno) {                                    \
+        fprintf(                                    \
+            stderr, "[%s:%d] %s%s: %s\n",           \
+            __FILE_NAME__, __LINE__,                \
+            #Callee, #ArgsList,                     \
+            strerror(errno)                         \
+        );                                          \
+        exit(EXIT_FAILURE);                         \
+    }                                               \
+    _r;                                             \
+})
+
+// Average number of keys per bucket. Larger buckets save memory but take
+// longer to place.
+#define FROZEN_MAP__KEYS_PER_BUCKET 4
+
+// Give up on a bucket after this many displacements. The build is then
+// retried with smaller buckets, down to a single key per bucket.
+#define FROZEN_MAP__MAX_DISPLACEMENT (1 << 16)
+
+#define FrozenMap(TKey, TValue)             \
+struct {                                    \
+    size_t Size;                            \
+    size_t BucketCount;                     \
+    size_t (*Hash)(TKey);                   \
+    bool (*KeyEquals)(TKey, TKey);          \
+    int32_t *Displacements;                 \
+    struct {                                \
+        TKey Key;                           \
+        TValue Value;                       \
+    } *Entries;                             \
+    Allocator Allocator;                    \
+}
+
+// Map a 32-bit value uniformly to [0, Count) without a division.
+#define FROZEN_MAP__Reduce(Value, Count) ((size_t) (((uint64_t) (uint32_t) (Value) * (Count)) >> 32))
+
+#define FROZEN_MAP__BucketOf(Hash_, BucketCount_) FROZEN_MAP__Reduce((Hash_), (BucketCount_))
+
+#define FROZEN_MAP__SlotOf(Hash_, Displacement, Size_) \
+    FROZEN_MAP__Reduce(Hash_UInt64((uint64_t) (Hash_) + (uint64_t) (Displacement)), (Size_))
+
+// Compare (key, bucket) pairs by both words, since qsort is not stable
+// and ties must not depend on the libc for the build to be deterministic.
+static inline int FROZEN_MAP__CompareSizes(void const *a, void const *b) {
+    size_t const *x = a, *y = b;
+    if (x[0] != y[0]) {
+        return (x[0] > y[0]) - (x[0] < y[0]);
+    }
+    return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+// Fill displacements for bucketCount buckets, and set slots[i] to the
+// slot of the key with hash hashes[i]. Return false if two keys have the
+// same hash or if some bucket cannot be placed.
+static inline bool FROZEN_MAP__Place(
+        size_t const *hashes,
+        size_t count,
+        size_t bucketCount,
+        int32_t *displacements,
+        size_t *slots
+) {
+    // Keys sorted by bucket, and buckets sorted by decreasing size, since
+    // large buckets are the hardest to place and go first.
+    size_t *starts = FROZEN_MAP__CallChecked(calloc, (bucketCount + 1, sizeof(size_t)));
+    size_t *keys = FROZEN_MAP__CallChecked(malloc, (count * sizeof(size_t)));
+    size_t *order = FROZEN_MAP__CallChecked(malloc, (bucketCount * 2 * sizeof(size_t)));
+    size_t *marks = FROZEN_MAP__CallChecked(calloc, (count, sizeof(size_t)));
+    bool *taken = FROZEN_MAP__CallChecked(calloc, (count, sizeof(bool)));
+    bool ok = true;
+
+    for (size_t i = 0; i < count; i++) {
+        starts[FROZEN_MAP__BucketOf(hashes[i], bucketCount) + 1]++;
+    }
+    for (size_t b = 0; b < bucketCount; b++) {
+        starts[b + 1] += starts[b];
+        // Sort by decreasing size, then by bucket index
+        order[2 * b] = SIZE_MAX - (starts[b + 1] - starts[b]);
+        order[2 * b + 1] = b;
+    }
+    qsort(order, bucketCount, 2 * sizeof(size_t), FROZEN_MAP__CompareSizes);
+    for (size_t i = 0; i < count; i++) {
+        size_t const b = FROZEN_MAP__BucketOf(hashes[i], bucketCount);
+        keys[starts[b] + marks[b]++] = i;
+    }
+    memset(marks, 0, count * sizeof(size_t));
+
+    size_t nextFree = 0;
+    size_t generation = 0;
+    for (size_t o = 0; ok && o < bucketCount; o++) {
+        size_t const b = order[2 * o + 1];
+        size_t const *bucket = keys + starts[b];
+        size_t const bucketSize = starts[b + 1] - starts[b];
+
+        if (0 == bucketSize) {
+            displacements[b] = 0;
+            continue;
+        }
+
+        if (1 == bucketSize) {
+            while (taken[nextFree]) {
+                nextFree++;
+            }
+            taken[nextFree] = true;
+            slots[bucket[0]] = nextFree;
+            displacements[b] = -(int32_t) nextFree - 1;
+            continue;
+        }
+
+        for (size_t i = 0; ok && i < bucketSize; i++) {
+            for (size_t j = 0; j < i; j++) {
+                ok = ok && hashes[bucket[i]] != hashes[bucket[j]];
+            }
+        }
+
+        int32_t d = 1;
+        for (; ok && d < FROZEN_MAP__MAX_DISPLACEMENT; d++) {
+            // marks[slot] == generation for slots claimed by this attempt
+            generation++;
+            size_t i = 0;
+            for (; i < bucketSize; i++) {
+                size_t const slot = FROZEN_MAP__SlotOf(hashes[bucket[i]], d, count);
+                if (taken[slot] || generation == marks[slot]) {
+                    break;
+                }
+                marks[slot] = generation;
+                slots[bucket[i]] = slot;
+            }
+            if (bucketSize == i) {
+                break;
+            }
+        }
+
+        ok = ok && d < FROZEN_MAP__MAX_DISPLACEMENT;
+        if (ok) {
+            for (size_t i = 0; i < bucketSize; i++) {
+                taken[slots[bucket[i]]] = true;
+            }
+            displacements[b] = d;
+        }
+    }
+
+    free(taken);
+    free(marks);
+    free(order);
+    free(keys);
+    free(starts);
+    return ok;
+}
+
+#define FrozenMap_Empty(FrozenMapType, Hash_, KeyEquals_) \
+    ((FrozenMapType) {.Hash = (Hash_), .KeyEquals = (KeyEquals_)})
+
+// Build the frozen map at FrozenMapPtr from the entries of Map_, with its
+// functions and allocator. Map_ is left unchanged. Return false, leaving
+// an empty frozen map, if two keys have the same hash or if the map has
+// more than INT32_MAX entries.
+#define FrozenMap_TryFrom(FrozenMapPtr, Map_)                                                  \
+({                                                                                             \
+    __auto_type _frozen_ptr_from = (FrozenMapPtr);                                             \
+    __auto_type _map_from = (Map_);                                                            \
+    *_frozen_ptr_from = (typeof(*_frozen_ptr_from)) {                                          \
+        .Hash = _map_from.Hash,                                                                \
+        .KeyEquals = _map_from.KeyEquals,                                                      \
+        .Allocator = _map_from.Allocator,                                                      \
+    };                                                                                         \
+    size_t const _count_from = _map_from.Size;                                                 \
+    bool _ok_from = _count_from <= INT32_MAX;                                                  \
+    if (_ok_from && _count_from > 0) {                                                         \
+        size_t *_hashes_from =                                                                 \
+            FROZEN_MAP__CallChecked(malloc, (2 * _count_from * sizeof(size_t)));               \
+        size_t *_slots_from = _hashes_from + _count_from;                                      \
+        typeof(_map_from.Entries) *_sources_from =                                             \
+            FROZEN_MAP__CallChecked(malloc, (_count_from * sizeof(*_sources_from)));           \
+        size_t _i_from = 0;                                                                    \
+        Map_ForEach(_entry_from, _map_from) {                                                  \
+            _sources_from[_i_from] = _entry_from;                                              \
+            _hashes_from[_i_from] = MAP__HashOf(*_frozen_ptr_from, _entry_from->Key);          \
+            _i_from++;                                                                         \
+        }                                                                                      \
+        size_t _bucketCount_from = 0;                                                          \
+        int32_t *_displacements_from = NULL;                                                   \
+        _ok_from = false;                                                                      \
+        for (                                                                                  \
+            size_t _perBucket_from = FROZEN_MAP__KEYS_PER_BUCKET;                              \
+            false == _ok_from && _perBucket_from > 0;                                          \
+            _perBucket_from /= 2                                                               \
+        ) {                                                                                    \
+            if (NULL != _displacements_from) {                                                 \
+                Allocator_Free(                                                                \
+                    _frozen_ptr_from->Allocator,                                               \
+                    _displacements_from,                                                       \
+                    _bucketCount_from * sizeof(int32_t));                                      \
+            }                                                                                  \
+            _bucketCount_from = (_count_from + _perBucket_from - 1) / _perBucket_from;         \
+            _displacements_from = FROZEN_MAP__CallChecked(                                     \
+                Allocator_Allocate, (                                                          \
+                    _frozen_ptr_from->Allocator,                                               \
+                    _bucketCount_from * sizeof(int32_t),                                       \
+                    alignof(int32_t)                                                           \
+                ));                                                                            \
+            _ok_from = FROZEN_MAP__Place(                                                      \
+                _hashes_from, _count_from, _bucketCount_from,                                  \
+                _displacements_from, _slots_from);                                             \
+        }                                                                                      \
+        if (_ok_from) {                                                                        \
+            _frozen_ptr_from->Entries = FROZEN_MAP__CallChecked(                               \
+                Allocator_Allocate, (                                                          \
+                    _frozen_ptr_from->Allocator,                                               \
+                    _count_from * sizeof(*_frozen_ptr_from->Entries),                          \
+                    alignof(typeof(*_frozen_ptr_from->Entries))                                \
+                ));                                                                            \
+            for (size_t _j_from = 0; _j_from < _count_from; _j_from++) {                       \
+                __auto_type _target_from = &(_frozen_ptr_from->Entries[_slots_from[_j_from]]); \
+                _target_from->Key = _sources_from[_j_from]->Key;                               \
+                _target_from->Value = _sources_from[_j_from]->Value;                           \
+            }                                                                                  \
+            _frozen_ptr_from->Displacements = _displacements_from;                             \
+            _frozen_ptr_from->BucketCount = _bucketCount_from;                                 \
+            _frozen_ptr_from->Size = _count_from;                                              \
+        } else {                                                                               \
+            Allocator_Free(                                                                    \
+                _frozen_ptr_from->Allocator,                                                   \
+                _displacements_from,                                                           \
+                _bucketCount_from * sizeof(int32_t));                                          \
+        }                                                                                      \
+        free(_sources_from);                                                                   \
+        free(_hashes_from);                                                                    \
+    }                                                                                          \
+    _ok_from;                                                                                  \
+})
+
+#define FrozenMap_Free(FrozenMapPtr)                                                    \
+do {                                                                                    \
+    __auto_type _frozen_ptr_free = (FrozenMapPtr);                                      \
+    if (_frozen_ptr_free->Size > 0) {                                                   \
+        Allocator_Free(                                                                 \
+            _frozen_ptr_free->Allocator,                                                \
+            _frozen_ptr_free->Displacements,                                            \
+            _frozen_ptr_free->BucketCount * sizeof(int32_t));                           \
+        Allocator_Free(                                                                 \
+            _frozen_ptr_free->Allocator,                                                \
+            _frozen_ptr_free->Entries,                                                  \
+            _frozen_ptr_free->Size * sizeof(*_frozen_ptr_free->Entries));               \
+    }                                                                                   \
+    *_frozen_ptr_free = (typeof(*_frozen_ptr_free)) {                                   \
+        .Hash = _frozen_ptr_free->Hash,                                                 \
+        .KeyEquals = _frozen_ptr_free->KeyEquals,                                       \
+        .Allocator = _frozen_ptr_free->Allocator,                                       \
+    };                                                                                  \
+} while (0)
+
+#define FROZEN_MAP__Find(FrozenMap_, Key_)                                               \
+({                                                                                       \
+    __auto_type _frozen_find = (FrozenMap_);                                             \
+    typeof(_frozen_find.Entries) _found_frozen = NULL;                                   \
+    if (_frozen_find.Size > 0) {                                                         \
+        typeof(_frozen_find.Entries->Key) _key_frozen = (Key_);                          \
+        size_t const _hash_frozen = MAP__HashOf(_frozen_find, _key_frozen);              \
+        int32_t const _displacement_frozen = _frozen_find.Displacements[                 \
+            FROZEN_MAP__BucketOf(_hash_frozen, _frozen_find.BucketCount)];               \
+        size_t const _slot_frozen = _displacement_frozen < 0                             \
+            ? (size_t) (-(int64_t) _displacement_frozen - 1)                             \
+            : FROZEN_MAP__SlotOf(_hash_frozen, _displacement_frozen, _frozen_find.Size); \
+        if (MAP__KeysEqual(                                                              \
+                _frozen_find, _key_frozen, _frozen_find.Entries[_slot_frozen].Key)) {    \
+            _found_frozen = &(_frozen_find.Entries[_slot_frozen]);                       \
+        }                                                                                \
+    }                                                                                    \
+    _found_frozen;                                                                       \
+})
+
+#define FrozenMap_At(FrozenMap_, Key_)                                    \
+({                                                                        \
+    __auto_type _slot_frozen_at = FROZEN_MAP__Find((FrozenMap_), (Key_)); \
+    (NULL == _slot_frozen_at ? NULL : &_slot_frozen_at->Value);           \
+})
+
+#define FrozenMap_TryGet(FrozenMap_, Key_, ValuePtr)                        \
+({                                                                          \
+    __auto_type _value_frozen_try_get = FrozenMap_At((FrozenMap_), (Key_)); \
+    if (NULL != _value_frozen_try_get) {                                    \
+        *(ValuePtr) = *_value_frozen_try_get;                               \
+    }                                                                       \
+    NULL != _value_frozen_try_get;                                          \
+})
+
+#define FrozenMap_GetOrDefault(FrozenMap_, Key_, DefaultExpr)                         \
+({                                                                                    \
+    typeof((FrozenMap_).Entries->Value) _value_frozen_or_default;                     \
+    if (false == FrozenMap_TryGet((FrozenMap_), (Key_), &_value_frozen_or_default)) { \
+        _value_frozen_or_default = (DefaultExpr);                                     \
+    }                                                                                 \
+    _value_frozen_or_default;                                                         \
+})
+
+// Entries are dense, so iteration is a plain loop over the array.
+#define FrozenMap_ForEach(EntryPtr, FrozenMap_)                                                     \
+__auto_type MAP__Concat(_frozen_for_each_, __LINE__) = (FrozenMap_);                                \
+for (                                                                                               \
+    typeof(MAP__Concat(_frozen_for_each_, __LINE__).Entries) EntryPtr =                             \
+        MAP__Concat(_frozen_for_each_, __LINE__).Entries;                                           \
+    EntryPtr < MAP__Concat(_frozen_for_each_, __LINE__).Entries                                     \
+        + MAP__Concat(_frozen_for_each_, __LINE__).Size;                                            \
+    EntryPtr++                                                                                      \
+)
+
+#define FrozenMap_IsEmpty(FrozenMap_) (0 == (FrozenMap_).Size)
+
+#endif // FROZEN_MAP_H
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "frozen_map.h"
+
+#include "testing/testing.h"
+
+typedef Map(int, int) IntIntMap;
+typedef FrozenMap(int, int) IntIntFrozenMap;
+typedef Map(char const *, int) StringIntMap;
+typedef FrozenMap(char const *, int) StringIntFrozenMap;
+
+size_t IntHashIdentity(int value) {
+    return (size_t) value;
+}
+
+size_t IntHashConst(int unused) {
+    (void) unused;
+    return 42;
+}
+
+bool IntEquals(int a, int b) { return a == b; }
+
+static size_t IntEqualsCalls = 0;
+
+bool CountingIntEquals(int a, int b) {
+    IntEqualsCalls++;
+    return a == b;
+}
+
+Testing_Fact(TryFrom_builds_map_with_all_entries_of_source) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    int const keysCount = 10000;
+    for (int i = 0; i < keysCount; i++) {
+        Map_Put(&source, i * 7919, i);
+    }
+
+    IntIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+
+    Testing_Assert(keysCount == (int) sut.Size, "expected size to be %d but was %zu", keysCount, sut.Size);
+    for (int i = 0; i < keysCount; i++) {
+        int const value = FrozenMap_GetOrDefault(sut, i * 7919, -1);
+        Testing_Assert(i == value, "expected value %d at key %d but got %d", i, i * 7919, value);
+    }
+    Testing_Assert(NULL == FrozenMap_At(sut, 1), "expected missing key to not be found");
+    Testing_Assert(keysCount == (int) source.Size, "expected source map to be left unchanged");
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_Fact(Lookup_compares_exactly_one_key) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashIdentity, CountingIntEquals);
+    for (int i = 0; i < 1000; i++) {
+        Map_Put(&source, i, i);
+    }
+
+    IntIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+
+    IntEqualsCalls = 0;
+    for (int i = -1000; i < 1000; i++) {
+        int value;
+        Testing_Assert((i >= 0) == FrozenMap_TryGet(sut, i, &value), "unexpected presence of key %d", i);
+    }
+    Testing_Assert(2000 == IntEqualsCalls, "expected one KeyEquals call per lookup but got %zu", IntEqualsCalls);
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_Fact(TryFrom_uses_default_functions_for_string_keys) {
+    StringIntMap source = Map_Of(
+        StringIntMap, NULL, NULL,
+        {.Key = "one", .Value = 1},
+        {.Key = "two", .Value = 2},
+        {.Key = "three", .Value = 3},
+    );
+
+    StringIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+
+    char key[] = "three";
+    Testing_Assert(3 == FrozenMap_GetOrDefault(sut, key, -1), "expected keys to be compared by contents");
+    Testing_Assert(-1 == FrozenMap_GetOrDefault(sut, "four", -1), "expected missing key to not be found");
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_Fact(TryFrom_fails_for_keys_with_identical_hashes) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashConst, IntEquals);
+    Map_Put(&source, 1, 1);
+    Map_Put(&source, 2, 2);
+
+    IntIntFrozenMap sut;
+    Testing_Assert(false == FrozenMap_TryFrom(&sut, source), "expected identical hashes to be rejected");
+    Testing_Assert(FrozenMap_IsEmpty(sut), "expected frozen map to be empty after failure");
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_Fact(TryFrom_accepts_empty_map) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    IntIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+    Testing_Assert(FrozenMap_IsEmpty(sut), "expected frozen map to be empty");
+    Testing_Assert(NULL == FrozenMap_At(sut, 0), "expected no key to be found");
+    FrozenMap_ForEach(entry, sut) {
+        Testing_Assert(false, "expected body to never be executed");
+    }
+
+    FrozenMap_Free(&sut);
+}
+
+Testing_Fact(ForEach_visits_every_entry_once) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    int const keysCount = 300;
+    for (int i = 0; i < keysCount; i++) {
+        Map_Put(&source, i, -i);
+    }
+
+    IntIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+
+    bool visited[keysCount];
+    memset(visited, 0x00, sizeof(visited));
+    int visitedCount = 0;
+    FrozenMap_ForEach(entry, sut) {
+        Testing_Assert(entry->Key >= 0 && entry->Key < keysCount, "unexpected key %d", entry->Key);
+        Testing_Assert(-entry->Key == entry->Value, "wrong value at key %d", entry->Key);
+        Testing_Assert(false == visited[entry->Key], "expected key %d to be visited once", entry->Key);
+        visited[entry->Key] = true;
+        visitedCount++;
+    }
+    Testing_Assert(keysCount == visitedCount, "expected %d entries to be visited but got %d", keysCount, visitedCount);
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_Fact(Displacements_take_less_memory_than_map_slots) {
+    IntIntMap source = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 5000; i++) {
+        Map_Put(&source, i, i);
+    }
+
+    IntIntFrozenMap sut;
+    Testing_Assert(FrozenMap_TryFrom(&sut, source), "expected frozen map to be built");
+
+    size_t const frozenBytes = sut.Size * sizeof(*sut.Entries) + sut.BucketCount * sizeof(*sut.Displacements);
+    size_t const mapBytes = source.Capacity * sizeof(*source.Entries);
+    Testing_Assert(frozenBytes < mapBytes, "expected %zu bytes to be fewer than %zu", frozenBytes, mapBytes);
+
+    FrozenMap_Free(&sut);
+    Map_Free(&source);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(TryFrom_builds_map_with_all_entries_of_source),
+        Testing_AddTest(Lookup_compares_exactly_one_key),
+        Testing_AddTest(TryFrom_uses_default_functions_for_string_keys),
+        Testing_AddTest(TryFrom_fails_for_keys_with_identical_hashes),
+        Testing_AddTest(TryFrom_accepts_empty_map),
+        Testing_AddTest(ForEach_visits_every_entry_once),
+        Testing_AddTest(Displacements_take_less_memory_than_map_slots),
+};
+
+Testing_RunAllTests();
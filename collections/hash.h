@@ -0,0 +1,163 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Hash functions for map keys.
+//
+// Hash_Bytes is a port of wyhash (final version 4): it consumes 8 bytes
+// per step (48 bytes per loop iteration in three independent lanes)
+// and passes SMHasher. Results depend on the byte order of the machine
+// and must not be persisted.
+//
+// Every Hash_X function has a matching Hash_XEquals function, so both can
+// be passed to Map_Empty and friends:
+//     Map_Empty(StringIntMap, Hash_CString, Hash_CStringEquals)
+
+static uint64_t const HASH__Secret[4] = {
+    UINT64_C(0x2d358dccaa6c78a5),
+    UINT64_C(0x8bb84b93962eacc9),
+    UINT64_C(0x4b33a62ed433d4a3),
+    UINT64_C(0x4d5a2da51de1aa47),
+};
+
+// Compute the 128-bit product of A and B and return its halves in *A and *B.
+static inline void HASH__Multiply(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t const r = (__uint128_t) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t const ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+    uint64_t const rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t const t = rl + (rm0 << 32);
+    uint64_t const lo = t + (rm1 << 32);
+    uint64_t const hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t HASH__Mix(uint64_t a, uint64_t b) {
+    HASH__Multiply(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t HASH__Read64(uint8_t const *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t HASH__Read32(uint8_t const *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Read 1 to 3 bytes.
+static inline uint64_t HASH__ReadSmall(uint8_t const *p, size_t length) {
+    return ((uint64_t) p[0] << 16) | ((uint64_t) p[length >> 1] << 8) | p[length - 1];
+}
+
+static inline uint64_t Hash_BytesWithSeed(void const *data, size_t length, uint64_t seed) {
+    uint8_t const *p = data;
+    uint64_t a, b;
+
+    seed ^= HASH__Mix(seed ^ HASH__Secret[0], HASH__Secret[1]);
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t const offset = (length >> 3) << 2;
+            a = (HASH__Read32(p) << 32) | HASH__Read32(p + offset);
+            b = (HASH__Read32(p + length - 4) << 32) | HASH__Read32(p + length - 4 - offset);
+        } else if (length > 0) {
+            a = HASH__ReadSmall(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t lane1 = seed, lane2 = seed;
+            do {
+                seed = HASH__Mix(HASH__Read64(p) ^ HASH__Secret[1], HASH__Read64(p + 8) ^ seed);
+                lane1 = HASH__Mix(HASH__Read64(p + 16) ^ HASH__Secret[2], HASH__Read64(p + 24) ^ lane1);
+                lane2 = HASH__Mix(HASH__Read64(p + 32) ^ HASH__Secret[3], HASH__Read64(p + 40) ^ lane2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (i > 16) {
+            seed = HASH__Mix(HASH__Read64(p) ^ HASH__Secret[1], HASH__Read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = HASH__Read64(p + i - 16);
+        b = HASH__Read64(p + i - 8);
+    }
+
+    a ^= HASH__Secret[1];
+    b ^= seed;
+    HASH__Multiply(&a, &b);
+    return HASH__Mix(a ^ HASH__Secret[0] ^ length, b ^ HASH__Secret[1]);
+}
+
+static inline size_t Hash_Bytes(void const *data, size_t length) {
+    return (size_t) Hash_BytesWithSeed(data, length, 0);
+}
+
+// Integer mixer: a single multiply-fold of the value with fixed constants,
+// using the same 128-bit mix as Hash_BytesWithSeed. Every bit of the result
+// depends on every bit of the input.
+static inline size_t Hash_UInt64(uint64_t value) {
+    return (size_t) HASH__Mix(value ^ HASH__Secret[0], HASH__Secret[1] ^ UINT64_C(0xa0761d6478bd642f));
+}
+
+static inline bool Hash_UInt64Equals(uint64_t a, uint64_t b) { return a == b; }
+
+static inline size_t Hash_Int64(int64_t value) { return Hash_UInt64((uint64_t) value); }
+
+static inline bool Hash_Int64Equals(int64_t a, int64_t b) { return a == b; }
+
+static inline size_t Hash_UInt(unsigned value) { return Hash_UInt64(value); }
+
+static inline bool Hash_UIntEquals(unsigned a, unsigned b) { return a == b; }
+
+static inline size_t Hash_Int(int value) { return Hash_UInt64((uint64_t) (int64_t) value); }
+
+static inline bool Hash_IntEquals(int a, int b) { return a == b; }
+
+static inline size_t Hash_Pointer(void const *value) { return Hash_UInt64((uintptr_t) value); }
+
+static inline bool Hash_PointerEquals(void const *a, void const *b) { return a == b; }
+
+static inline size_t Hash_CString(char const *value) { return Hash_Bytes(value, strlen(value)); }
+
+static inline bool Hash_CStringEquals(char const *a, char const *b) { return 0 == strcmp(a, b); }
+
+// Hash and compare the contents of spans, see span.h. Unlike the
+// functions above, these are macros because every span type is distinct;
+// wrap them in a function to use spans as map keys.
+#define Hash_Span(Span_)                                                       \
+({                                                                             \
+    __auto_type _span_hash = (Span_);                                          \
+    Hash_Bytes(_span_hash.Items, _span_hash.Size * sizeof(*_span_hash.Items)); \
+})
+
+#define Hash_SpanEquals(A, B)                                           \
+({                                                                      \
+    __auto_type _a_span_equals = (A);                                   \
+    __auto_type _b_span_equals = (B);                                   \
+    _a_span_equals.Size == _b_span_equals.Size                          \
+        && (0 == _a_span_equals.Size || 0 == memcmp(                    \
+            _a_span_equals.Items,                                       \
+            _b_span_equals.Items,                                       \
+            _a_span_equals.Size * sizeof(*_a_span_equals.Items)));      \
+})
+
+#endif // HASH_H
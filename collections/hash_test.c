@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "hash.h"
+#include "map.h"
+#include "span.h"
+
+#include "testing/testing.h"
+
+typedef Span(int) IntSpan;
+
+Testing_Fact(Bytes_returns_same_hash_for_same_contents) {
+    char buffer[128];
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (char) (i * 7);
+    }
+
+    for (size_t length = 0; length <= 100; length++) {
+        char copy[101];
+        memcpy(copy + 1, buffer, length);
+        Testing_Assert(
+            Hash_Bytes(buffer, length) == Hash_Bytes(copy + 1, length),
+            "expected hash of %zu bytes to not depend on their address", length);
+    }
+}
+
+Testing_Fact(Bytes_returns_distinct_hashes_for_prefixes) {
+    char buffer[200] = {0};
+    size_t const count = sizeof(buffer) + 1;
+    size_t hashes[count];
+
+    for (size_t length = 0; length < count; length++) {
+        hashes[length] = Hash_Bytes(buffer, length);
+        for (size_t other = 0; other < length; other++) {
+            Testing_Assert(
+                hashes[other] != hashes[length],
+                "expected hashes of %zu and %zu zero bytes to differ", other, length);
+        }
+    }
+}
+
+Testing_Fact(Bytes_changes_about_half_of_the_bits_when_one_input_bit_changes) {
+    uint8_t buffer[64] = {0};
+    size_t totalFlipped = 0;
+    size_t minFlipped = 64;
+    size_t const base = Hash_Bytes(buffer, sizeof(buffer));
+
+    for (size_t bit = 0; bit < 8 * sizeof(buffer); bit++) {
+        buffer[bit / 8] ^= 1u << (bit % 8);
+        size_t const flipped = (size_t) __builtin_popcountll(base ^ Hash_Bytes(buffer, sizeof(buffer)));
+        buffer[bit / 8] ^= 1u << (bit % 8);
+
+        totalFlipped += flipped;
+        minFlipped = flipped < minFlipped ? flipped : minFlipped;
+    }
+
+    double const average = (double) totalFlipped / (8 * sizeof(buffer));
+    Testing_Assert(average > 28 && average < 36, "expected about 32 bits to change but got %f", average);
+    Testing_Assert(minFlipped > 12, "expected every input bit to affect many output bits but got %zu", minFlipped);
+}
+
+Testing_Fact(BytesWithSeed_depends_on_seed) {
+    char const data[] = "some data";
+
+    Testing_Assert(
+        Hash_BytesWithSeed(data, sizeof(data), 1) != Hash_BytesWithSeed(data, sizeof(data), 2),
+        "expected different seeds to give different hashes");
+    Testing_Assert(
+        Hash_BytesWithSeed(data, sizeof(data), 0) == Hash_Bytes(data, sizeof(data)),
+        "expected Hash_Bytes to use seed 0");
+}
+
+Testing_Fact(UInt64_spreads_small_integers_over_low_bits) {
+    bool seen[256] = {0};
+    size_t distinct = 0;
+
+    for (uint64_t i = 0; i < 256; i++) {
+        size_t const low = Hash_UInt64(i << 20) & 0xFF;
+        distinct += false == seen[low];
+        seen[low] = true;
+    }
+
+    Testing_Assert(distinct > 128, "expected low bits to be well distributed but got %zu distinct values", distinct);
+}
+
+Testing_Fact(Integer_and_pointer_functions_agree_with_equality) {
+    int const values[] = {0, 1, -1, 42};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        Testing_Assert(Hash_Int(values[i]) == Hash_Int64(values[i]), "expected int and int64 hashes to agree");
+        Testing_Assert(Hash_IntEquals(values[i], values[i]), "expected value to equal itself");
+    }
+
+    Testing_Assert(Hash_UInt(7) == Hash_UInt64(7), "expected unsigned and uint64 hashes to agree");
+    Testing_Assert(false == Hash_UIntEquals(7, 8), "expected different values to not be equal");
+    Testing_Assert(Hash_Pointer(values) == Hash_Pointer(&values[0]), "expected pointers to be hashed by address");
+    Testing_Assert(false == Hash_PointerEquals(&values[0], &values[1]), "expected pointers to be compared by address");
+}
+
+Testing_Fact(CString_functions_compare_contents) {
+    char first[] = "hello";
+    char second[] = "hello";
+
+    Testing_Assert(Hash_CString(first) == Hash_CString(second), "expected equal strings to have equal hashes");
+    Testing_Assert(Hash_CStringEquals(first, second), "expected equal strings to be equal");
+    Testing_Assert(Hash_CString("hello") != Hash_CString("hellO"), "expected different strings to have different hashes");
+    Testing_Assert(false == Hash_CStringEquals("hello", "hell"), "expected different strings to not be equal");
+}
+
+Testing_Fact(Span_functions_compare_contents) {
+    int first[] = {1, 2, 3, 4};
+    int second[] = {0, 1, 2, 3, 4};
+
+    IntSpan const a = Span_FromArray(IntSpan, first);
+    IntSpan const b = Span_SliceFrom(IntSpan, Span_FromArray(IntSpan, second), 1);
+    IntSpan const c = Span_SliceTo(IntSpan, b, 3);
+
+    Testing_Assert(Hash_Span(a) == Hash_Span(b), "expected equal spans to have equal hashes");
+    Testing_Assert(Hash_SpanEquals(a, b), "expected equal spans to be equal");
+    Testing_Assert(Hash_Span(a) != Hash_Span(c), "expected different spans to have different hashes");
+    Testing_Assert(false == Hash_SpanEquals(a, c), "expected different spans to not be equal");
+    Testing_Assert(Hash_SpanEquals(Span_Empty(IntSpan), Span_Empty(IntSpan)), "expected empty spans to be equal");
+}
+
+Testing_Fact(Functions_can_be_used_with_Map) {
+    typedef Map(char const *, int) StringIntMap;
+    StringIntMap sut = Map_Empty(StringIntMap, Hash_CString, Hash_CStringEquals);
+
+    char key[] = "two";
+    Map_Put(&sut, "one", 1);
+    Map_Put(&sut, "two", 2);
+
+    Testing_Assert(2 == Map_GetOrDefault(sut, key, -1), "expected value 2 at key two");
+    Testing_Assert(NULL == Map_At(sut, "three"), "expected missing key to not be found");
+
+    Map_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Bytes_returns_same_hash_for_same_contents),
+        Testing_AddTest(Bytes_returns_distinct_hashes_for_prefixes),
+        Testing_AddTest(Bytes_changes_about_half_of_the_bits_when_one_input_bit_changes),
+        Testing_AddTest(BytesWithSeed_depends_on_seed),
+        Testing_AddTest(UInt64_spreads_small_integers_over_low_bits),
+        Testing_AddTest(Integer_and_pointer_functions_agree_with_equality),
+        Testing_AddTest(CString_functions_compare_contents),
+        Testing_AddTest(Span_functions_compare_contents),
+        Testing_AddTest(Functions_can_be_used_with_Map),
+};
+
+Testing_RunAllTests();
@@ -1,8 +1,14 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
 
 #define LIST__CallChecked(Callee, ArgsList) \
 ({                                          \
@@ -23,34 +29,41 @@
 #define LIST__Concat_(A, B)   A ## B
 #define LIST__Concat(A, B)    LIST__Concat_(A, B)
 
-#define List(TValue)    \
-struct {                \
-    size_t Size;        \
-    struct {            \
-        TValue Value;   \
-        void *Prev;     \
-        void *Next;     \
-    } *Head, *Tail;     \
+#define List(TValue)        \
+struct {                    \
+    size_t Size;            \
+    struct {                \
+        TValue Value;       \
+        void *Prev;         \
+        void *Next;         \
+    } *Head, *Tail;         \
+    Allocator Allocator;    \
 }
 
 #define List_Empty(ListType) ((ListType) {0})
 
-#define List_Free(ListPtr)                                          \
-do {                                                                \
-    __auto_type _listPtr_free = (ListPtr);                          \
-    typeof(_listPtr_free->Head) _cur_free = _listPtr_free->Head;    \
-    while (NULL != _cur_free) {                                     \
-        typeof(_listPtr_free->Head) _next_free = _cur_free->Next;   \
-        free(_cur_free);                                            \
-        _cur_free = _next_free;                                     \
-    }                                                               \
-    *_listPtr_free = List_Empty(typeof(*_listPtr_free));            \
+#define List_WithAllocator(ListType, Allocator_) ((ListType) {.Allocator = (Allocator_)})
+
+#define List_Free(ListPtr)                                                          \
+do {                                                                                \
+    __auto_type _listPtr_free = (ListPtr);                                          \
+    typeof(_listPtr_free->Head) _cur_free = _listPtr_free->Head;                    \
+    while (NULL != _cur_free) {                                                     \
+        typeof(_listPtr_free->Head) _next_free = _cur_free->Next;                   \
+        Allocator_Free(_listPtr_free->Allocator, _cur_free, sizeof(*_cur_free));    \
+        _cur_free = _next_free;                                                     \
+    }                                                                               \
+    *_listPtr_free = List_WithAllocator(                                            \
+        typeof(*_listPtr_free),                                                     \
+        _listPtr_free->Allocator                                                    \
+    );                                                                              \
 } while (0)
 
-#define LIST__NewNode(NodeType, Val, Next_, Prev_)              \
+#define LIST__NewNode(Allocator_, NodeType, Val, Next_, Prev_)  \
 ({                                                              \
     NodeType *const _newNode = (NodeType *) LIST__CallChecked(  \
-        calloc, (1, sizeof(*_newNode))                          \
+        Allocator_Allocate,                                     \
+        ((Allocator_), sizeof(NodeType), alignof(NodeType))     \
     );                                                          \
     *_newNode = (NodeType) {                                    \
         .Value = (Val),                                         \
@@ -70,6 +83,7 @@ do {                                                                \
 do {                                                            \
     __auto_type _listPtr_pushFront = (ListPtr);                 \
     __auto_type _newNodePtr_pushFront = LIST__NewNode(          \
+        _listPtr_pushFront->Allocator,                          \
         typeof(*_listPtr_pushFront->Head),                      \
         (Val),                                                  \
         _listPtr_pushFront->Head,                               \
@@ -86,6 +100,7 @@ do {                                                            \
 do {                                                            \
     __auto_type _listPtr_pushBack = (ListPtr);                  \
     __auto_type _newNodePtr_pushBack = LIST__NewNode(           \
+        _listPtr_pushBack->Allocator,                           \
         typeof(*_listPtr_pushBack->Head),                       \
         (Val),                                                  \
         NULL,                                                   \
@@ -115,7 +130,11 @@ do {                                                            \
         }                                                                               \
         _listPtr_tryPopFront->Head = _head_tryPopFront->Next;                           \
         _listPtr_tryPopFront->Size--;                                                   \
-        free(_head_tryPopFront);                                                        \
+        Allocator_Free(                                                                 \
+            _listPtr_tryPopFront->Allocator,                                            \
+            _head_tryPopFront,                                                          \
+            sizeof(*_head_tryPopFront)                                                  \
+        );                                                                              \
         _ok = true;                                                                     \
     }                                                                                   \
     _ok;                                                                                \
@@ -138,7 +157,11 @@ do {                                                            \
         }                                                                               \
         _listPtr_tryPopBack->Tail = _tail_tryPopBack->Prev;                             \
         _listPtr_tryPopBack->Size--;                                                    \
-        free(_tail_tryPopBack);                                                         \
+        Allocator_Free(                                                                 \
+            _listPtr_tryPopBack->Allocator,                                             \
+            _tail_tryPopBack,                                                           \
+            sizeof(*_tail_tryPopBack)                                                   \
+        );                                                                              \
         _ok = true;                                                                     \
     }                                                                                   \
     _ok;                                                                                \
@@ -1,9 +1,16 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
+#include "hash.h"
 
 #define MAP__CallChecked(Callee, ArgsList)  \
 ({                                          \
@@ -26,117 +33,599 @@
 
 #define MAP__ArrayLength(Array)         (sizeof(Array) / sizeof(*(Array)))
 
-#define Map(TKey, TValue)           \
-struct {                            \
-    size_t Size;                    \
-    size_t Capacity;                \
-    size_t (*Hash)(TKey);           \
-    bool (*KeyEquals)(TKey, TKey);  \
-    struct {                        \
-        TKey Key;                   \
-        TValue Value;               \
-        bool Used;                  \
-    } *Entries;                     \
+// Capacity is always zero or a power of two, so that slot indices can be
+// computed with a mask rather than a division.
+#define MAP_INITIAL_CAPACITY 8
+
+// Scramble the bits of a user-provided hash, so that hashes differing
+// only in high bits, such as identity hashes of aligned pointers, still
+// spread over the low bits used by the mask.
+#define MAP__Mix(Hash) Hash_UInt64(Hash)
+
+static inline size_t MAP__RoundUpToPowerOfTwo(size_t n) {
+    size_t capacity = MAP_INITIAL_CAPACITY;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Hash and equality used for integer and C string keys when a map is
+// created with NULL Hash_ and KeyEquals_. They are selected by the key
+// type at compile time, so unlike the function pointers they can be
+// inlined into the probe loop. Integer keys are hashed as is, since every
+// hash goes through MAP__Mix anyway.
+static inline size_t MAP__HashInteger(uint64_t key) {
+    return (size_t) key;
+}
+
+#define MAP__DefaultFor(Key_, IntegerFunction, StringFunction, Fallback)   \
+_Generic((Key_),                                                            \
+    _Bool: IntegerFunction,                                                 \
+    char: IntegerFunction,                                                  \
+    signed char: IntegerFunction,                                           \
+    unsigned char: IntegerFunction,                                         \
+    short: IntegerFunction,                                                 \
+    unsigned short: IntegerFunction,                                        \
+    int: IntegerFunction,                                                   \
+    unsigned int: IntegerFunction,                                          \
+    long: IntegerFunction,                                                  \
+    unsigned long: IntegerFunction,                                         \
+    long long: IntegerFunction,                                             \
+    unsigned long long: IntegerFunction,                                    \
+    char *: StringFunction,                                                 \
+    char const *: StringFunction,                                           \
+    default: Fallback)
+
+#define MAP__Hash(Map_, Key_)                                                       \
+(NULL == (Map_).Hash                                                                \
+    ? MAP__DefaultFor((Key_), MAP__HashInteger, Hash_CString, (Map_).Hash)(Key_)    \
+    : (Map_).Hash(Key_))
+
+#define MAP__KeysEqual(Map_, A, B)                                                          \
+(NULL == (Map_).KeyEquals                                                                   \
+    ? MAP__DefaultFor((A), Hash_UInt64Equals, Hash_CStringEquals, (Map_).KeyEquals)(A, B)  \
+    : (Map_).KeyEquals(A, B))
+
+#define MAP__HashOf(Map_, Key_) MAP__Mix(MAP__Hash((Map_), (Key_)))
+
+#define MAP__IndexOf(Map_, Hash) ((Hash) & ((Map_).Capacity - 1))
+
+#define MAP__HomeIndex(Map_, Key_) MAP__IndexOf((Map_), MAP__HashOf((Map_), (Key_)))
+
+#define MAP__NextIndex(Map_, Index) (((Index) + 1) & ((Map_).Capacity - 1))
+
+#define MAP__PrevIndex(Map_, Index) (((Index) - 1) & ((Map_).Capacity - 1))
+
+// When RehashStep is not zero, growing the map does not move all entries
+// at once. The previous table is kept as OldEntries, and every Put or
+// Remove moves the next RehashStep of its slots, starting at OldStart, to
+// the new table. Migrated counts the slots processed so far.
+#define MAP__Type(TKey, TValue, HashCount)  \
+struct {                                    \
+    size_t Size;                            \
+    size_t Capacity;                        \
+    size_t (*Hash)(TKey);                   \
+    bool (*KeyEquals)(TKey, TKey);          \
+    struct {                                \
+        TKey Key;                           \
+        TValue Value;                       \
+        size_t Hash[HashCount];             \
+        uint32_t Distance;                  \
+        bool Used;                          \
+    } *Entries, *OldEntries;                \
+    size_t OldCapacity;                     \
+    size_t OldStart;                        \
+    size_t Migrated;                        \
+    size_t RehashStep;                      \
+    Allocator Allocator;                    \
+}
+
+#define Map(TKey, TValue) MAP__Type(TKey, TValue, 0)
+
+// A map that stores the mixed hash of each key in its entry. Growing it
+// never calls Hash, and KeyEquals is only called for entries whose stored
+// hash matches, which pays off for keys that are expensive to hash or
+// compare, such as strings. All Map_ functions accept it.
+#define HashCachingMap(TKey, TValue) MAP__Type(TKey, TValue, 1)
+
+// Entries of a plain Map have a zero-length Hash array, so these copy
+// nothing and MAP__StoredHash returns Fallback, which lets the compiler
+// drop the hash comparison altogether.
+#define MAP__CachesHash(Map_) (0 != sizeof((Map_).Entries->Hash))
+
+#define MAP__StoredHash(EntryPtr, Fallback)                             \
+({                                                                      \
+    size_t _stored_hash = (Fallback);                                   \
+    memcpy(&_stored_hash, (EntryPtr)->Hash, sizeof((EntryPtr)->Hash));  \
+    _stored_hash;                                                       \
+})
+
+#define MAP__StoreHash(EntryPtr, Hash_)                                     \
+do {                                                                        \
+    size_t const _hash_to_store = (Hash_);                                  \
+    memcpy((EntryPtr)->Hash, &_hash_to_store, sizeof((EntryPtr)->Hash));    \
+} while (0)
+
+// Each table is a single allocation: Capacity entries followed by an
+// occupancy bitmap, with bit i set iff Entries[i].Used. Iteration scans the
+// bitmap a word at a time instead of reading every entry.
+#define MAP__BitmapOffset(EntrySize, Capacity_)                                  \
+(((EntrySize) * (Capacity_) + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1))
+
+#define MAP__TableSize(EntrySize, Capacity_)                                               \
+(MAP__BitmapOffset((EntrySize), (Capacity_)) + ((Capacity_) + 63) / 64 * sizeof(uint64_t))
+
+#define MAP__Occupied(Entries_, Capacity_)                                                 \
+((uint64_t *) ((char *) (Entries_) + MAP__BitmapOffset(sizeof(*(Entries_)), (Capacity_))))
+
+#define MAP__SetOccupied(Entries_, Capacity_, Index)                                    \
+(MAP__Occupied((Entries_), (Capacity_))[(Index) / 64] |= UINT64_C(1) << ((Index) % 64))
+
+#define MAP__ClearOccupied(Entries_, Capacity_, Index)                                     \
+(MAP__Occupied((Entries_), (Capacity_))[(Index) / 64] &= ~(UINT64_C(1) << ((Index) % 64)))
+
+static inline bool MAP__TryFindNextSetBit(uint64_t const *bitmap, size_t count, size_t base, size_t *next) {
+    if (base >= count) {
+        return false;
+    }
+    size_t word = base / 64;
+    uint64_t bits = bitmap[word] & (~UINT64_C(0) << (base % 64));
+    while (0 == bits) {
+        word++;
+        if (word * 64 >= count) {
+            return false;
+        }
+        bits = bitmap[word];
+    }
+    *next = word * 64 + (size_t) __builtin_ctzll(bits);
+    return *next < count;
 }
 
+#define MAP__AllocateTable(MapPtr, Capacity_)                                           \
+({                                                                                      \
+    __auto_type _map_ptr_allocate = (MapPtr);                                           \
+    size_t const _size_allocate =                                                       \
+        MAP__TableSize(sizeof(*(_map_ptr_allocate->Entries)), (Capacity_));             \
+    size_t const _alignment_allocate =                                                  \
+        alignof(typeof(*(_map_ptr_allocate->Entries))) > alignof(uint64_t)              \
+            ? alignof(typeof(*(_map_ptr_allocate->Entries)))                            \
+            : alignof(uint64_t);                                                        \
+    typeof(_map_ptr_allocate->Entries) _table_allocate =                                \
+        MAP__CallChecked(Allocator_Allocate, (                                          \
+            _map_ptr_allocate->Allocator,                                               \
+            _size_allocate,                                                             \
+            _alignment_allocate                                                         \
+        ));                                                                             \
+    memset(_table_allocate, 0, _size_allocate);                                         \
+    _table_allocate;                                                                    \
+})
+
+#define MAP__FreeTable(MapPtr, Entries_, Capacity_)                                     \
+do {                                                                                    \
+    __auto_type _map_ptr_free_table = (MapPtr);                                         \
+    Allocator_Free(                                                                     \
+        _map_ptr_free_table->Allocator,                                                 \
+        (Entries_),                                                                     \
+        MAP__TableSize(sizeof(*(_map_ptr_free_table->Entries)), (Capacity_))            \
+    );                                                                                  \
+} while (0)
+
 #define Map_Empty(MapType, Hash_, KeyEquals_) ((MapType) {.Hash = (Hash_), .KeyEquals = (KeyEquals_)})
 
-#define MAP__WithEntries(Map_, ...)                                             \
-({                                                                              \
-    __auto_type _map_withEntries = (Map_);                                      \
-    typeof(_map_withEntries.Entries[0]) _newEntries[] = {__VA_ARGS__};          \
-    size_t const _newEntriesCount = MAP__ArrayLength(_newEntries);              \
-    for (                                                                       \
-        size_t _i_withEntries = 0;                                              \
-        _i_withEntries < _newEntriesCount;                                      \
-        _i_withEntries++                                                        \
-    ) {                                                                         \
-        Map_Put(                                                                \
-            &_map_withEntries,                                                  \
-            _newEntries[_i_withEntries].Key,                                    \
-            _newEntries[_i_withEntries].Value);                                 \
-    }                                                                           \
-    _map_withEntries;                                                           \
+#define Map_WithAllocator(MapType, Hash_, KeyEquals_, Allocator_)  \
+((MapType) {                                                        \
+    .Hash = (Hash_),                                                \
+    .KeyEquals = (KeyEquals_),                                      \
+    .Allocator = (Allocator_),                                      \
+})
+
+#define MAP__WithEntries(Map_, ...)                                                     \
+({                                                                                      \
+    __auto_type _map_withEntries = (Map_);                                              \
+    typeof(_map_withEntries.Entries[0]) _newEntries[] = {__VA_ARGS__};                  \
+    Map_PutAllFromPtr(&_map_withEntries, _newEntries, MAP__ArrayLength(_newEntries));   \
+    _map_withEntries;                                                                   \
 })
 
 #define Map_Of(MapType, Hash_, KeyEquals_, ...) MAP__WithEntries(Map_Empty(MapType, Hash_, KeyEquals_), ##__VA_ARGS__)
 
-#define Map_Free(MapPtr)                    \
-do {                                        \
-    free((MapPtr)->Entries);                \
-    *(MapPtr) = Map_Empty(                  \
-        typeof(*(MapPtr)),                  \
-        (MapPtr)->Hash,                     \
-        (MapPtr)->KeyEquals                 \
-    );                                      \
+#define Map_Free(MapPtr)                                                    \
+do {                                                                        \
+    __auto_type _map_ptr_free = (MapPtr);                                   \
+    MAP__FreeTable(                                                         \
+        _map_ptr_free,                                                      \
+        _map_ptr_free->Entries,                                             \
+        _map_ptr_free->Capacity                                             \
+    );                                                                      \
+    if (NULL != _map_ptr_free->OldEntries) {                                \
+        MAP__FreeTable(                                                     \
+            _map_ptr_free,                                                  \
+            _map_ptr_free->OldEntries,                                      \
+            _map_ptr_free->OldCapacity                                      \
+        );                                                                  \
+    }                                                                       \
+    size_t const _rehashStep_free = _map_ptr_free->RehashStep;              \
+    *_map_ptr_free = Map_WithAllocator(                                     \
+        typeof(*_map_ptr_free),                                             \
+        _map_ptr_free->Hash,                                                \
+        _map_ptr_free->KeyEquals,                                           \
+        _map_ptr_free->Allocator                                            \
+    );                                                                      \
+    _map_ptr_free->RehashStep = _rehashStep_free;                           \
 } while (0)
 
-#define MAP__FindSlot(Map_, Key_)                                                       \
+// Entries are kept in Robin Hood order: every entry stores its distance
+// from its home slot, and a run of entries is sorted by home slot. A
+// lookup can therefore stop at the first entry that is closer to its own
+// home than the probed key would be, instead of scanning until an empty
+// slot.
+#define MAP__Probe(Map_, Entries_, Mask, Key_, Hash_, StartIndex, StartDistance)        \
 ({                                                                                      \
-    __auto_type _map_find_slot = (Map_);                                                \
-    typeof(*(_map_find_slot.Entries)) *_found_slot = NULL;                              \
-    if (_map_find_slot.Capacity > 0) {                                                  \
-        size_t _index = _map_find_slot.Hash(Key_) % _map_find_slot.Capacity;            \
-        for (size_t _i_fs = 0; _i_fs < _map_find_slot.Capacity; _i_fs++) {              \
-            __auto_type _item = _map_find_slot.Entries[_index];                         \
-            if (false == _item.Used || _map_find_slot.KeyEquals((Key_), _item.Key)) {   \
-                break;                                                                  \
-            }                                                                           \
-            _index = (_index + 1) % _map_find_slot.Capacity;                            \
+    typeof(Entries_) _entries_probe = (Entries_);                                       \
+    typeof(_entries_probe) _found_probe = NULL;                                         \
+    size_t const _mask_probe = (Mask);                                                  \
+    size_t _index_probe = (StartIndex);                                                 \
+    for (                                                                               \
+        uint32_t _distance_probe = (StartDistance);                                     \
+        _entries_probe[_index_probe].Used                                               \
+            && _entries_probe[_index_probe].Distance >= _distance_probe;                \
+        _distance_probe++                                                               \
+    ) {                                                                                 \
+        __auto_type _entry_probe = &(_entries_probe[_index_probe]);                     \
+        if (                                                                            \
+            MAP__StoredHash(_entry_probe, (Hash_)) == (Hash_)                           \
+            && MAP__KeysEqual((Map_), (Key_), _entry_probe->Key)                        \
+        ) {                                                                             \
+            _found_probe = _entry_probe;                                                \
+            break;                                                                      \
         }                                                                               \
-        _found_slot = &(_map_find_slot.Entries[_index]);                                \
+        _index_probe = (_index_probe + 1) & _mask_probe;                                \
     }                                                                                   \
-    _found_slot;                                                                        \
+    _found_probe;                                                                       \
+})
+
+// While the map is being migrated, a key that is not in the new table
+// may still be in the old one. Migration empties old slots in order from
+// OldStart, which follows an empty slot, so the remaining entries keep
+// their Robin Hood order. A key whose home slot has already been
+// migrated can only be found past the migrated slots, so its probe starts
+// there, at the matching distance.
+#define MAP__ProbeOld(Map_, Key_, Hash_)                                                \
+({                                                                                      \
+    __auto_type _map_probe_old = (Map_);                                                \
+    size_t const _mask_probe_old = _map_probe_old.OldCapacity - 1;                      \
+    size_t _index_probe_old = (Hash_) & _mask_probe_old;                                \
+    size_t _distance_probe_old = 0;                                                     \
+    size_t const _offset_probe_old =                                                    \
+        (_index_probe_old - _map_probe_old.OldStart) & _mask_probe_old;                 \
+    if (_offset_probe_old < _map_probe_old.Migrated) {                                  \
+        _distance_probe_old = _map_probe_old.Migrated - _offset_probe_old;              \
+        _index_probe_old =                                                              \
+            (_map_probe_old.OldStart + _map_probe_old.Migrated) & _mask_probe_old;      \
+    }                                                                                   \
+    MAP__Probe(                                                                         \
+        _map_probe_old, _map_probe_old.OldEntries, _mask_probe_old,                     \
+        (Key_), (Hash_), _index_probe_old, _distance_probe_old                          \
+    );                                                                                  \
+})
+
+// Hash_ is the mixed hash of Key_, and is only evaluated if the map is
+// not empty.
+#define MAP__FindWithHash(Map_, Key_, Hash_)                                            \
+({                                                                                      \
+    __auto_type _map_find = (Map_);                                                     \
+    typeof(*(_map_find.Entries)) *_found = NULL;                                        \
+    if (_map_find.Capacity > 0) {                                                       \
+        typeof(_map_find.Entries->Key) _key_find = (Key_);                              \
+        size_t const _hash_find = (Hash_);                                              \
+        _found = MAP__Probe(                                                            \
+            _map_find, _map_find.Entries, _map_find.Capacity - 1,                       \
+            _key_find, _hash_find, MAP__IndexOf(_map_find, _hash_find), 0               \
+        );                                                                              \
+        if (NULL == _found && NULL != _map_find.OldEntries) {                           \
+            _found = MAP__ProbeOld(_map_find, _key_find, _hash_find);                   \
+        }                                                                               \
+    }                                                                                   \
+    _found;                                                                             \
+})
+
+#define MAP__Find(Map_, Key_)                                           \
+({                                                                      \
+    __auto_type _map_find_key = (Map_);                                 \
+    typeof(_map_find_key.Entries->Key) _key_find_key = (Key_);          \
+    MAP__FindWithHash(                                                  \
+        _map_find_key,                                                  \
+        _key_find_key,                                                  \
+        MAP__HashOf(_map_find_key, _key_find_key)                       \
+    );                                                                  \
+})
+
+// Insert a key that is known to be absent, with mixed hash Hash_, at
+// Index, where a lookup for it stopped at distance Distance_ from its
+// home slot. The map must have at least one free slot. The rest of the
+// run is shifted one slot forward to make room, which keeps it sorted by
+// home slot. Return a pointer to the new entry, whose value is left
+// uninitialized.
+#define MAP__InsertAt(MapPtr, Index, Distance_, Key_, Hash_)                            \
+({                                                                                      \
+    __auto_type _map_ptr_insert = (MapPtr);                                             \
+    __auto_type _entries_insert = _map_ptr_insert->Entries;                             \
+    size_t const _index_insert = (Index);                                               \
+    size_t _empty_insert = _index_insert;                                               \
+    while (_entries_insert[_empty_insert].Used) {                                       \
+        _empty_insert = MAP__NextIndex(*_map_ptr_insert, _empty_insert);                \
+    }                                                                                   \
+    MAP__SetOccupied(_entries_insert, _map_ptr_insert->Capacity, _empty_insert);        \
+    while (_empty_insert != _index_insert) {                                            \
+        size_t const _prev_insert = MAP__PrevIndex(*_map_ptr_insert, _empty_insert);    \
+        _entries_insert[_empty_insert] = _entries_insert[_prev_insert];                 \
+        _entries_insert[_empty_insert].Distance += 1;                                   \
+        _empty_insert = _prev_insert;                                                   \
+    }                                                                                   \
+    _entries_insert[_index_insert].Key = (Key_);                                        \
+    MAP__StoreHash(&(_entries_insert[_index_insert]), (Hash_));                         \
+    _entries_insert[_index_insert].Distance = (Distance_);                              \
+    _entries_insert[_index_insert].Used = true;                                         \
+    &(_entries_insert[_index_insert]);                                                  \
+})
+
+// Same as MAP__InsertAt, but look up the insertion point first.
+#define MAP__Insert(MapPtr, Key_, Hash_)                                                \
+({                                                                                      \
+    __auto_type _map_ptr_locate = (MapPtr);                                             \
+    __auto_type _entries_locate = _map_ptr_locate->Entries;                             \
+    size_t const _hash_locate = (Hash_);                                                \
+    size_t _index_locate = MAP__IndexOf(*_map_ptr_locate, _hash_locate);                \
+    uint32_t _distance_locate = 0;                                                      \
+    while (                                                                             \
+        _entries_locate[_index_locate].Used                                             \
+        && _entries_locate[_index_locate].Distance >= _distance_locate                  \
+    ) {                                                                                 \
+        _index_locate = MAP__NextIndex(*_map_ptr_locate, _index_locate);                \
+        _distance_locate++;                                                             \
+    }                                                                                   \
+    MAP__InsertAt(                                                                      \
+        _map_ptr_locate, _index_locate, _distance_locate, (Key_), _hash_locate);        \
 })
 
 #define MAP__Reserve(MapPtr, NewCapacity)                               \
 do {                                                                    \
     __auto_type _map_ptr_reserve = (MapPtr);                            \
+    MAP__Migrate(_map_ptr_reserve, SIZE_MAX);                           \
     size_t const _oldCapacity = _map_ptr_reserve->Capacity;             \
-    size_t const _newCapacity = (NewCapacity);                          \
+    size_t const _newCapacity = MAP__RoundUpToPowerOfTwo(NewCapacity);  \
     if (_oldCapacity >= _newCapacity) { break; }                        \
                                                                         \
     __auto_type _oldEntries = _map_ptr_reserve->Entries;                \
-    _map_ptr_reserve->Entries = MAP__CallChecked(                       \
-        calloc, (_newCapacity, sizeof(*(_map_ptr_reserve->Entries)))    \
-    );                                                                  \
+    _map_ptr_reserve->Entries =                                         \
+        MAP__AllocateTable(_map_ptr_reserve, _newCapacity);             \
     _map_ptr_reserve->Capacity = _newCapacity;                          \
                                                                         \
     for (size_t _i = 0; _i < _oldCapacity; _i++) {                      \
-        __auto_type _e = _oldEntries[_i];                               \
-        if (false == _e.Used) {                                         \
+        __auto_type _e = &(_oldEntries[_i]);                            \
+        if (false == _e->Used) {                                        \
             continue;                                                   \
         }                                                               \
-        __auto_type _slot = MAP__FindSlot(*_map_ptr_reserve, _e.Key);   \
-        *_slot = _e;                                                    \
+        size_t const _hash_reserve = MAP__CachesHash(*_map_ptr_reserve) \
+            ? MAP__StoredHash(_e, 0)                                    \
+            : MAP__HashOf(*_map_ptr_reserve, _e->Key);                  \
+        MAP__Insert(_map_ptr_reserve, _e->Key, _hash_reserve)->Value =  \
+            _e->Value;                                                  \
     }                                                                   \
                                                                         \
-    _map_ptr_reserve->Capacity = _newCapacity;                          \
-    free(_oldEntries);                                                  \
+    MAP__FreeTable(_map_ptr_reserve, _oldEntries, _oldCapacity);        \
 } while (0)
 
+// Move up to Count slots of the old table to the new one, and free the
+// old table once all of its slots have been moved. Migrated entries are
+// only marked unused: the entries that follow them must stay in place for
+// MAP__ProbeOld to find them.
+#define MAP__Migrate(MapPtr, Count)                                                    \
+do {                                                                                   \
+    __auto_type _map_ptr_migrate = (MapPtr);                                           \
+    if (NULL == _map_ptr_migrate->OldEntries) {                                        \
+        break;                                                                         \
+    }                                                                                  \
+    size_t const _mask_migrate = _map_ptr_migrate->OldCapacity - 1;                    \
+    for (                                                                              \
+        size_t _left_migrate = (Count);                                                \
+        _left_migrate > 0                                                              \
+            && _map_ptr_migrate->Migrated < _map_ptr_migrate->OldCapacity;             \
+        _left_migrate--, _map_ptr_migrate->Migrated++                                  \
+    ) {                                                                                \
+        size_t const _i_migrate =                                                      \
+            (_map_ptr_migrate->OldStart + _map_ptr_migrate->Migrated) & _mask_migrate; \
+        __auto_type _e_migrate = &(_map_ptr_migrate->OldEntries[_i_migrate]);          \
+        if (false == _e_migrate->Used) {                                               \
+            continue;                                                                  \
+        }                                                                              \
+        size_t const _hash_migrate = MAP__CachesHash(*_map_ptr_migrate)                \
+            ? MAP__StoredHash(_e_migrate, 0)                                           \
+            : MAP__HashOf(*_map_ptr_migrate, _e_migrate->Key);                         \
+        MAP__Insert(_map_ptr_migrate, _e_migrate->Key, _hash_migrate)->Value =         \
+            _e_migrate->Value;                                                         \
+        _e_migrate->Used = false;                                                      \
+        MAP__ClearOccupied(                                                            \
+            _map_ptr_migrate->OldEntries, _map_ptr_migrate->OldCapacity, _i_migrate);  \
+    }                                                                                  \
+    if (_map_ptr_migrate->Migrated == _map_ptr_migrate->OldCapacity) {                 \
+        MAP__FreeTable(                                                                \
+            _map_ptr_migrate,                                                          \
+            _map_ptr_migrate->OldEntries,                                              \
+            _map_ptr_migrate->OldCapacity                                              \
+        );                                                                             \
+        _map_ptr_migrate->OldEntries = NULL;                                           \
+        _map_ptr_migrate->OldCapacity = 0;                                             \
+        _map_ptr_migrate->OldStart = 0;                                                \
+        _map_ptr_migrate->Migrated = 0;                                                \
+    }                                                                                  \
+} while (0)
+
+// Robin Hood ordering keeps probe sequences short even when the table is
+// nearly full, so the map is only grown past 7/8 load.
+#define MAP__NeedsToGrow(Map_, NewSize) (8 * (NewSize) > 7 * (Map_).Capacity)
+
+// Double the capacity. With incremental rehashing, any migration still in
+// progress is finished first, and the current table becomes the old one.
+// Migration starts right after one of its empty slots, so that no probe
+// run crosses the boundary between migrated and remaining slots.
+#define MAP__Grow(MapPtr)                                                           \
+do {                                                                                \
+    __auto_type _map_ptr_grow = (MapPtr);                                           \
+    size_t const _capacity_grow = _map_ptr_grow->Capacity;                          \
+    if (0 == _map_ptr_grow->RehashStep || 0 == _capacity_grow) {                    \
+        MAP__Reserve(_map_ptr_grow, 2 * _capacity_grow);                            \
+        break;                                                                      \
+    }                                                                               \
+    MAP__Migrate(_map_ptr_grow, SIZE_MAX);                                          \
+                                                                                    \
+    __auto_type _entries_grow =                                                     \
+        MAP__AllocateTable(_map_ptr_grow, 2 * _capacity_grow);                      \
+                                                                                    \
+    size_t _empty_grow = 0;                                                         \
+    while (_map_ptr_grow->Entries[_empty_grow].Used) {                              \
+        _empty_grow++;                                                              \
+    }                                                                               \
+    _map_ptr_grow->OldEntries = _map_ptr_grow->Entries;                             \
+    _map_ptr_grow->OldCapacity = _capacity_grow;                                    \
+    _map_ptr_grow->OldStart = (_empty_grow + 1) & (_capacity_grow - 1);             \
+    _map_ptr_grow->Migrated = 0;                                                    \
+    _map_ptr_grow->Entries = _entries_grow;                                         \
+    _map_ptr_grow->Capacity = 2 * _capacity_grow;                                   \
+} while (0)
+
+// Smallest capacity that holds Count entries without exceeding the load
+// limit of MAP__NeedsToGrow.
+#define MAP__CapacityFor(Count) MAP__RoundUpToPowerOfTwo((8 * (Count) + 6) / 7)
+
+#define Map_Reserve(MapPtr, ExpectedCount)                              \
+do {                                                                    \
+    size_t const _expectedCount = (ExpectedCount);                      \
+    if (_expectedCount > 0) {                                           \
+        MAP__Reserve((MapPtr), MAP__CapacityFor(_expectedCount));       \
+    }                                                                   \
+} while (0)
+
+// Find the entry of Key_, or insert a new one if Key_ is not present,
+// probing each table only once: on a miss, the Robin Hood lookup in the
+// new table stops exactly where the key has to be inserted. Only when
+// the map has to grow first is the insertion point looked up again.
+// Set *InsertedPtr to whether the entry is new; its value is then left
+// uninitialized. Hash_ is the mixed hash of Key_.
+#define MAP__UpsertWithHash(MapPtr, Key_, Hash_, InsertedPtr)                           \
+({                                                                                      \
+    __auto_type _map_ptr_upsert = (MapPtr);                                             \
+    MAP__Migrate(_map_ptr_upsert, _map_ptr_upsert->RehashStep);                         \
+    __auto_type _entries_upsert = _map_ptr_upsert->Entries;                             \
+    typeof(_entries_upsert->Key) _key_upsert = (Key_);                                  \
+    size_t const _hash_upsert = (Hash_);                                                \
+    typeof(_entries_upsert) _slot_upsert = NULL;                                        \
+    size_t _index_upsert = 0;                                                           \
+    uint32_t _distance_upsert = 0;                                                      \
+    if (_map_ptr_upsert->Capacity > 0) {                                                \
+        _index_upsert = MAP__IndexOf(*_map_ptr_upsert, _hash_upsert);                   \
+        while (                                                                         \
+            _entries_upsert[_index_upsert].Used                                         \
+            && _entries_upsert[_index_upsert].Distance >= _distance_upsert              \
+        ) {                                                                             \
+            __auto_type _entry_upsert = &(_entries_upsert[_index_upsert]);              \
+            if (                                                                        \
+                MAP__StoredHash(_entry_upsert, _hash_upsert) == _hash_upsert            \
+                && MAP__KeysEqual(*_map_ptr_upsert, _key_upsert, _entry_upsert->Key)    \
+            ) {                                                                         \
+                _slot_upsert = _entry_upsert;                                           \
+                break;                                                                  \
+            }                                                                           \
+            _index_upsert = MAP__NextIndex(*_map_ptr_upsert, _index_upsert);            \
+            _distance_upsert++;                                                         \
+        }                                                                               \
+        if (NULL == _slot_upsert && NULL != _map_ptr_upsert->OldEntries) {              \
+            _slot_upsert = MAP__ProbeOld(*_map_ptr_upsert, _key_upsert, _hash_upsert);  \
+        }                                                                               \
+    }                                                                                   \
+    *(InsertedPtr) = NULL == _slot_upsert;                                              \
+    if (NULL == _slot_upsert) {                                                         \
+        if (MAP__NeedsToGrow(*_map_ptr_upsert, _map_ptr_upsert->Size + 1)) {            \
+            MAP__Grow(_map_ptr_upsert);                                                 \
+            _slot_upsert = MAP__Insert(_map_ptr_upsert, _key_upsert, _hash_upsert);     \
+        } else {                                                                        \
+            _slot_upsert = MAP__InsertAt(                                               \
+                _map_ptr_upsert, _index_upsert, _distance_upsert,                       \
+                _key_upsert, _hash_upsert);                                             \
+        }                                                                               \
+        _map_ptr_upsert->Size += 1;                                                     \
+    }                                                                                   \
+    _slot_upsert;                                                                       \
+})
+
+#define MAP__Upsert(MapPtr, Key_, InsertedPtr)                                  \
+({                                                                              \
+    __auto_type _map_ptr_upsert_key = (MapPtr);                                 \
+    typeof(_map_ptr_upsert_key->Entries->Key) _key_upsert_key = (Key_);         \
+    MAP__UpsertWithHash(                                                        \
+        _map_ptr_upsert_key, _key_upsert_key,                                   \
+        MAP__HashOf(*_map_ptr_upsert_key, _key_upsert_key), (InsertedPtr));     \
+})
+
 #define Map_Put(MapPtr, Key_, Value_)                                   \
 ({                                                                      \
-    __auto_type _map_ptr_put = (MapPtr);                                \
-    if (3 * (_map_ptr_put->Size + 1) >= 2 * _map_ptr_put->Capacity) {   \
-        MAP__Reserve(_map_ptr_put, 3 * _map_ptr_put->Capacity / 2 + 3); \
-    }                                                                   \
-    __auto_type _slot_put = MAP__FindSlot(*_map_ptr_put, (Key_));       \
+    bool _inserted_put;                                                 \
+    __auto_type _slot_put =                                             \
+        MAP__Upsert((MapPtr), (Key_), &_inserted_put);                  \
     _slot_put->Value = (Value_);                                        \
-    if (false == _slot_put->Used) {                                     \
-        _slot_put->Key = (Key_);                                        \
-        _slot_put->Used = true;                                         \
-        _map_ptr_put->Size += 1;                                        \
-    }                                                                   \
     &(_slot_put->Value);                                                \
 })
 
+#define Map_TryPut(MapPtr, Key_, Value_)                                        \
+({                                                                              \
+    bool _inserted_try_put;                                                     \
+    __auto_type _slot_try_put =                                                 \
+        MAP__Upsert((MapPtr), (Key_), &_inserted_try_put);                      \
+    if (_inserted_try_put) {                                                    \
+        _slot_try_put->Value = (Value_);                                        \
+    }                                                                           \
+    _inserted_try_put;                                                          \
+})
+
+#define Map_GetOrInsert(MapPtr, Key_, DefaultExpr)                              \
+({                                                                              \
+    bool _inserted_get_or_insert;                                               \
+    __auto_type _slot_get_or_insert =                                           \
+        MAP__Upsert((MapPtr), (Key_), &_inserted_get_or_insert);                \
+    if (_inserted_get_or_insert) {                                              \
+        _slot_get_or_insert->Value = (DefaultExpr);                             \
+    }                                                                           \
+    (struct { typeof(_slot_get_or_insert->Value) *Value; bool Inserted; }) {    \
+        .Value = &(_slot_get_or_insert->Value),                                 \
+        .Inserted = _inserted_get_or_insert,                                    \
+    };                                                                          \
+})
+
+#define Map_PutAllFromPtr(MapPtr, Ptr, Count)                                \
+do {                                                                         \
+    __auto_type _map_ptr_put_all = (MapPtr);                                 \
+    __auto_type _ptr_put_all = (Ptr);                                        \
+    size_t const _count_put_all = (Count);                                   \
+    Map_Reserve(_map_ptr_put_all, _map_ptr_put_all->Size + _count_put_all);  \
+    for (size_t _i_put_all = 0; _i_put_all < _count_put_all; _i_put_all++) { \
+        Map_Put(                                                             \
+            _map_ptr_put_all,                                                \
+            _ptr_put_all[_i_put_all].Key,                                    \
+            _ptr_put_all[_i_put_all].Value);                                 \
+    }                                                                        \
+} while (0)
+
+#define Map_PutAll(MapPtr, Src)                                             \
+do {                                                                        \
+    __auto_type _src_put_all = (Src);                                       \
+    Map_PutAllFromPtr((MapPtr), _src_put_all.Items, _src_put_all.Size);     \
+} while (0)
+
 #define Map_At(Map_, Key_)                                  \
 ({                                                          \
-    __auto_type _slot_at = MAP__FindSlot((Map_), (Key_));   \
-    (NULL == _slot_at || false == _slot_at->Used            \
-        ? NULL :                                            \
-        &_slot_at->Value);                                  \
+    __auto_type _slot_at = MAP__Find((Map_), (Key_));       \
+    (NULL == _slot_at ? NULL : &_slot_at->Value);           \
 })
 
 #define Map_TryGet(Map_, Key_, ValuePtr)                    \
@@ -157,20 +646,85 @@ do {                                                                    \
     _value_or_default;                                              \
 })
 
-#define MAP__TryFindNextUsedIndex(Map_, BaseIndex, NextIndexPtr)        \
+// Shift the rest of the run back by one slot, until an empty slot or an
+// entry that is already in its home slot, so no tombstone is left. This
+// also works in the old table during migration: the remaining entries of
+// a run never cross into migrated slots.
+#define MAP__EraseIn(Entries_, Capacity_, EntryPtr)                         \
+do {                                                                        \
+    __auto_type _entries_erase = (Entries_);                                \
+    size_t const _mask_erase = (Capacity_) - 1;                             \
+    size_t _hole_erase = (EntryPtr) - _entries_erase;                       \
+    size_t _next_erase = (_hole_erase + 1) & _mask_erase;                   \
+    while (                                                                 \
+        _entries_erase[_next_erase].Used                                    \
+        && _entries_erase[_next_erase].Distance > 0                         \
+    ) {                                                                     \
+        _entries_erase[_hole_erase] = _entries_erase[_next_erase];          \
+        _entries_erase[_hole_erase].Distance -= 1;                          \
+        _hole_erase = _next_erase;                                          \
+        _next_erase = (_next_erase + 1) & _mask_erase;                      \
+    }                                                                       \
+    _entries_erase[_hole_erase].Used = false;                               \
+    MAP__ClearOccupied(_entries_erase, _mask_erase + 1, _hole_erase);       \
+} while (0)
+
+#define MAP__Erase(MapPtr, EntryPtr)                                                         \
+do {                                                                                         \
+    __auto_type _map_ptr_erase = (MapPtr);                                                   \
+    __auto_type _entry_erase = (EntryPtr);                                                   \
+    if (                                                                                     \
+        NULL != _map_ptr_erase->OldEntries                                                   \
+        && _entry_erase >= _map_ptr_erase->OldEntries                                        \
+        && _entry_erase < _map_ptr_erase->OldEntries + _map_ptr_erase->OldCapacity           \
+    ) {                                                                                      \
+        MAP__EraseIn(_map_ptr_erase->OldEntries, _map_ptr_erase->OldCapacity, _entry_erase); \
+    } else {                                                                                 \
+        MAP__EraseIn(_map_ptr_erase->Entries, _map_ptr_erase->Capacity, _entry_erase);       \
+    }                                                                                        \
+    _map_ptr_erase->Size -= 1;                                                               \
+} while (0)
+
+#define Map_Remove(MapPtr, Key_)                                        \
 ({                                                                      \
-    __auto_type _map_try_find_next_index = (Map_);                      \
-    size_t _i_next = (BaseIndex);                                       \
-    bool _ok = false;                                                   \
-    for (; _i_next < _map_try_find_next_index.Capacity; _i_next++) {    \
-        if (false == _map_try_find_next_index.Entries[_i_next].Used) {  \
-            continue;                                                   \
-        }                                                               \
-        *(NextIndexPtr) = _i_next;                                      \
-        _ok = true;                                                     \
-        break;                                                          \
+    __auto_type _map_ptr_remove = (MapPtr);                             \
+    MAP__Migrate(_map_ptr_remove, _map_ptr_remove->RehashStep);         \
+    __auto_type _slot_remove = MAP__Find(*_map_ptr_remove, (Key_));     \
+    if (NULL != _slot_remove) {                                         \
+        MAP__Erase(_map_ptr_remove, _slot_remove);                      \
     }                                                                   \
-     _ok;                                                               \
+    NULL != _slot_remove;                                               \
+})
+
+// Iteration indices past Capacity refer to the old table.
+#define MAP__EntryAt(Map_, Index)                           \
+((Index) < (Map_).Capacity                                  \
+    ? &((Map_).Entries[(Index)])                            \
+    : &((Map_).OldEntries[(Index) - (Map_).Capacity]))
+
+#define MAP__TryFindNextUsedIndex(Map_, BaseIndex, NextIndexPtr)                \
+({                                                                              \
+    __auto_type _map_try_find_next_index = (Map_);                              \
+    size_t const _capacity_next = _map_try_find_next_index.Capacity;            \
+    size_t const _base_next = (BaseIndex);                                      \
+    size_t _i_next = 0;                                                         \
+    bool _ok = _base_next < _capacity_next && MAP__TryFindNextSetBit(           \
+        MAP__Occupied(_map_try_find_next_index.Entries, _capacity_next),        \
+        _capacity_next, _base_next, &_i_next);                                  \
+    if (false == _ok && NULL != _map_try_find_next_index.OldEntries) {          \
+        _ok = MAP__TryFindNextSetBit(                                           \
+            MAP__Occupied(                                                      \
+                _map_try_find_next_index.OldEntries,                            \
+                _map_try_find_next_index.OldCapacity),                          \
+            _map_try_find_next_index.OldCapacity,                               \
+            _base_next > _capacity_next ? _base_next - _capacity_next : 0,      \
+            &_i_next);                                                          \
+        _i_next += _capacity_next;                                              \
+    }                                                                           \
+    if (_ok) {                                                                  \
+        *(NextIndexPtr) = _i_next;                                              \
+    }                                                                           \
+     _ok;                                                                       \
 })
 
 #define Map_ForEach(EntryPtr, Map_)                                                                 \
@@ -183,7 +737,7 @@ for (
             MAP__Concat(_i_, __LINE__),                                                             \
             &MAP__Concat(_i_, __LINE__)                                                             \
         )                                                                                           \
-            ? &(MAP__Concat(_map_for_each_, __LINE__).Entries[MAP__Concat(_i_, __LINE__)])          \
+            ? MAP__EntryAt(MAP__Concat(_map_for_each_, __LINE__), MAP__Concat(_i_, __LINE__))       \
             : NULL;                                                                                 \
     NULL != EntryPtr;                                                                               \
     EntryPtr =                                                                                      \
@@ -192,7 +746,7 @@ for (
             MAP__Concat(_i_, __LINE__) + 1,                                                         \
             &MAP__Concat(_i_, __LINE__)                                                             \
         )                                                                                           \
-            ? &(MAP__Concat(_map_for_each_, __LINE__).Entries[MAP__Concat(_i_, __LINE__)])          \
+            ? MAP__EntryAt(MAP__Concat(_map_for_each_, __LINE__), MAP__Concat(_i_, __LINE__))       \
             : NULL                                                                                  \
 )
 
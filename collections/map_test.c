@@ -3,6 +3,7 @@
 #include <stdbool.h>
 
 #include "map.h"
+#include "span.h"
 
 #include "testing/testing.h"
 
@@ -35,6 +36,19 @@ size_t IntHashConst(int unused) {
 
 bool IntEquals(int a, int b) { return a == b; }
 
+static size_t StrHashCalls = 0;
+static size_t StrEqualsCalls = 0;
+
+size_t CountingStrHash(char const *s) {
+    StrHashCalls++;
+    return StrHash(s);
+}
+
+bool CountingStrEquals(char const *s1, char const *s2) {
+    StrEqualsCalls++;
+    return StrEquals(s1, s2);
+}
+
 Testing_Fact(Empty_returns_map_with_Size_set_to_0) {
     IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
 
@@ -164,6 +178,130 @@ Testing_Fact(Put_handles_collisions_with_constant_hash) {
     Map_Free(&sut);
 }
 
+Testing_Fact(Put_keeps_capacity_a_power_of_two) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 1000; i++) {
+        Map_Put(&sut, i, i);
+        Testing_Assert(
+            0 == (sut.Capacity & (sut.Capacity - 1)),
+            "expected capacity to be a power of two but was %zu", sut.Capacity);
+        Testing_Assert(sut.Size < sut.Capacity, "expected at least one free slot");
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Put_handles_hashes_differing_only_in_high_bits) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    size_t const keysCount = 100;
+    for (int i = 0; i < (int) keysCount; i++) {
+        Map_Put(&sut, i << 16, i);
+    }
+
+    Testing_Assert(keysCount == sut.Size, "expected size to be %zu but was %zu", keysCount, sut.Size);
+    for (int i = 0; i < (int) keysCount; i++) {
+        int const value = Map_GetOrDefault(sut, i << 16, -1);
+        Testing_Assert(i == value, "expected value %d at key %d but got %d", i, i << 16, value);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Put_fills_table_up_to_seven_eighths_before_growing) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 7; i++) {
+        Map_Put(&sut, i, i);
+    }
+    Testing_Assert(8 == sut.Capacity, "expected capacity to be 8 but was %zu", sut.Capacity);
+
+    Map_Put(&sut, 7, 7);
+    Testing_Assert(16 == sut.Capacity, "expected capacity to be 16 but was %zu", sut.Capacity);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Put_stores_distance_of_each_entry_from_its_home_slot) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    unsigned state = 42;
+    for (int i = 0; i < 500; i++) {
+        state = state * 1103515245 + 12345;
+        Map_Put(&sut, (int) (state >> 4), i);
+        if (0 == i % 7) {
+            Map_Remove(&sut, (int) (state >> 4));
+        }
+    }
+
+    for (size_t i = 0; i < sut.Capacity; i++) {
+        if (false == sut.Entries[i].Used) {
+            continue;
+        }
+        size_t const home = MAP__HomeIndex(sut, sut.Entries[i].Key);
+        size_t const distance = (i - home) & (sut.Capacity - 1);
+        Testing_Assert(
+            distance == sut.Entries[i].Distance,
+            "expected distance %zu at slot %zu but was %u", distance, i, sut.Entries[i].Distance);
+
+        size_t const prev = (i - 1) & (sut.Capacity - 1);
+        Testing_Assert(
+            sut.Entries[i].Distance == 0
+                || (sut.Entries[prev].Used && sut.Entries[prev].Distance + 1 >= sut.Entries[i].Distance),
+            "expected slot %zu to not be closer to its home than slot %zu", prev, i);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Empty_uses_default_functions_for_integer_keys_when_given_NULL) {
+    typedef Map(long long, int) LongIntMap;
+    LongIntMap sut = Map_Empty(LongIntMap, NULL, NULL);
+
+    for (long long i = 0; i < 100; i++) {
+        Map_Put(&sut, i * INT64_C(0x100000000), (int) i);
+    }
+
+    Testing_Assert(100 == sut.Size, "expected size to be 100 but was %zu", sut.Size);
+    for (long long i = 0; i < 100; i++) {
+        int const value = Map_GetOrDefault(sut, i * INT64_C(0x100000000), -1);
+        Testing_Assert(i == value, "expected value %lld but got %d", i, value);
+    }
+    Testing_Assert(NULL == Map_At(sut, 1), "expected missing key to not be found");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Empty_uses_default_functions_for_string_keys_when_given_NULL) {
+    StringIntMap sut = Map_Empty(StringIntMap, NULL, NULL);
+
+    char key[] = "key";
+    Map_Put(&sut, "key", 1);
+    Map_Put(&sut, "other", 2);
+
+    Testing_Assert(2 == sut.Size, "expected size to be 2 but was %zu", sut.Size);
+    Testing_Assert(1 == Map_GetOrDefault(sut, key, -1), "expected keys to be compared by contents");
+    Testing_Assert(2 == Map_GetOrDefault(sut, "other", -1), "expected value 2 at key other");
+    Testing_Assert(NULL == Map_At(sut, "missing"), "expected missing key to not be found");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Of_accepts_NULL_functions) {
+    IntIntMap sut = Map_Of(
+            IntIntMap, NULL, NULL,
+            { .Key = 1, .Value = 2 },
+            { .Key = 2, .Value = 7 }
+    );
+
+    Testing_Assert(2 == sut.Size, "expected size to be 2 but was %zu", sut.Size);
+    Testing_Assert(7 == Map_GetOrDefault(sut, 2, -1), "expected value 7 at key 2");
+    Testing_Assert(true == Map_Remove(&sut, 1), "expected key 1 to be removed");
+
+    Map_Free(&sut);
+}
+
 Testing_Fact(Size_is_equal_to_number_of_distinct_keys_inserted) {
     IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
 
@@ -372,6 +510,529 @@ Testing_Fact(ForEach_iterates_over_all_elements) {
     Map_Free(&sut);
 }
 
+Testing_Fact(Remove_returns_false_if_key_does_not_exist) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    Testing_Assert(false == Map_Remove(&sut, 1), "expected Remove to return false for empty map");
+
+    Map_Put(&sut, 2, 4);
+    Testing_Assert(false == Map_Remove(&sut, 1), "expected Remove to return false for missing key");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Remove_deletes_key_and_decreases_size) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    Map_Put(&sut, 1, 1);
+    Map_Put(&sut, 2, 4);
+
+    Testing_Assert(true == Map_Remove(&sut, 1), "expected Remove to return true for existing key");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+    Testing_Assert(NULL == Map_At(sut, 1), "expected removed key to not be found");
+    Testing_Assert(4 == Map_GetOrDefault(sut, 2, -1), "expected other keys to be kept");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Remove_keeps_colliding_keys_reachable) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashConst, IntEquals);
+
+    int const keysCount = 40;
+    for (int i = 0; i < keysCount; i++) {
+        Map_Put(&sut, i, i * i);
+    }
+
+    for (int i = 0; i < keysCount; i += 3) {
+        Testing_Assert(true == Map_Remove(&sut, i), "expected key %d to be removed", i);
+    }
+
+    for (int i = 0; i < keysCount; i++) {
+        int value;
+        bool const found = Map_TryGet(sut, i, &value);
+        if (0 == i % 3) {
+            Testing_Assert(false == found, "expected key %d to be removed", i);
+        } else {
+            Testing_Assert(found, "expected key %d to be found", i);
+            Testing_Assert(i * i == value, "expected value %d at key %d but got %d", i * i, i, value);
+        }
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Remove_keeps_map_consistent_under_churn) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    bool present[256] = {0};
+    size_t expectedSize = 0;
+    unsigned state = 12345;
+    for (int step = 0; step < 20000; step++) {
+        state = state * 1103515245 + 12345;
+        int const key = (int) ((state >> 8) % 256);
+        if (state & 1) {
+            expectedSize += false == present[key];
+            present[key] = true;
+            Map_Put(&sut, key, key);
+        } else {
+            expectedSize -= present[key];
+            Testing_Assert(present[key] == Map_Remove(&sut, key), "unexpected Remove result for key %d", key);
+            present[key] = false;
+        }
+    }
+
+    Testing_Assert(expectedSize == sut.Size, "expected size to be %zu but was %zu", expectedSize, sut.Size);
+    for (int key = 0; key < 256; key++) {
+        Testing_Assert(present[key] == (NULL != Map_At(sut, key)), "unexpected presence of key %d", key);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Reserve_allows_inserting_expected_count_without_growing) {
+    size_t const counts[] = {1, 7, 8, 100, 1000, 4096};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+        Map_Reserve(&sut, counts[c]);
+        size_t const capacity = sut.Capacity;
+        Testing_Assert(capacity > counts[c], "expected capacity to exceed %zu but was %zu", counts[c], capacity);
+        Testing_Assert(capacity <= 4 * counts[c] || capacity == MAP_INITIAL_CAPACITY, "expected capacity %zu to not be excessive", capacity);
+
+        for (int i = 0; i < (int) counts[c]; i++) {
+            Map_Put(&sut, i, i);
+        }
+        Testing_Assert(capacity == sut.Capacity, "expected capacity to stay %zu but was %zu", capacity, sut.Capacity);
+
+        Map_Free(&sut);
+    }
+}
+
+Testing_Fact(Reserve_keeps_entries_and_never_shrinks) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 100; i++) {
+        Map_Put(&sut, i, -i);
+    }
+    size_t const capacity = sut.Capacity;
+
+    Map_Reserve(&sut, 0);
+    Map_Reserve(&sut, 10);
+    Testing_Assert(capacity == sut.Capacity, "expected capacity to stay %zu but was %zu", capacity, sut.Capacity);
+
+    Map_Reserve(&sut, 10000);
+    Testing_Assert(sut.Capacity > 10000, "expected capacity to grow but was %zu", sut.Capacity);
+    Testing_Assert(100 == sut.Size, "expected size to be 100 but was %zu", sut.Size);
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(-i == Map_GetOrDefault(sut, i, 1), "expected value %d at key %d", -i, i);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(PutAllFromPtr_inserts_all_entries_with_later_ones_winning) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    Map_Put(&sut, 1, 100);
+
+    struct { int Key; int Value; } const entries[] = {
+            { .Key = 1, .Value = 1 },
+            { .Key = 2, .Value = 2 },
+            { .Key = 3, .Value = 3 },
+            { .Key = 2, .Value = 4 },
+    };
+    Map_PutAllFromPtr(&sut, entries, sizeof(entries) / sizeof(entries[0]));
+
+    Testing_Assert(3 == sut.Size, "expected size to be 3 but was %zu", sut.Size);
+    Testing_Assert(1 == Map_GetOrDefault(sut, 1, -1), "expected existing value to be overwritten");
+    Testing_Assert(4 == Map_GetOrDefault(sut, 2, -1), "expected last value for duplicate key");
+    Testing_Assert(3 == Map_GetOrDefault(sut, 3, -1), "expected value 3 at key 3");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(PutAll_inserts_items_of_a_span_in_one_allocation) {
+    typedef struct { int Key; int Value; } IntIntPair;
+    typedef Span(IntIntPair) IntIntPairSpan;
+
+    IntIntPair pairs[1000];
+    for (int i = 0; i < 1000; i++) {
+        pairs[i] = (IntIntPair) { .Key = i, .Value = 2 * i };
+    }
+
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    Map_PutAll(&sut, Span_FromArray(IntIntPairSpan, pairs));
+    size_t const capacity = sut.Capacity;
+
+    Testing_Assert(1000 == sut.Size, "expected size to be 1000 but was %zu", sut.Size);
+    Testing_Assert(MAP__CapacityFor(1000) == capacity, "expected table to be sized once, but capacity was %zu", capacity);
+    for (int i = 0; i < 1000; i++) {
+        Testing_Assert(2 * i == Map_GetOrDefault(sut, i, -1), "expected value %d at key %d", 2 * i, i);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(HashCachingMap_never_rehashes_keys_when_growing) {
+    typedef HashCachingMap(char const *, int) CachingStringIntMap;
+    CachingStringIntMap sut = Map_Empty(CachingStringIntMap, CountingStrHash, CountingStrEquals);
+
+    static char keys[1000][8];
+    size_t const keysCount = sizeof(keys) / sizeof(keys[0]);
+    for (size_t i = 0; i < keysCount; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+    }
+
+    StrHashCalls = 0;
+    StrEqualsCalls = 0;
+    for (size_t i = 0; i < keysCount; i++) {
+        Map_Put(&sut, keys[i], (int) i);
+    }
+
+    Testing_Assert(keysCount == sut.Size, "expected size to be %zu but was %zu", keysCount, sut.Size);
+    Testing_Assert(keysCount == StrHashCalls, "expected one Hash call per Put but got %zu", StrHashCalls);
+    Testing_Assert(0 == StrEqualsCalls, "expected no KeyEquals calls for distinct hashes but got %zu", StrEqualsCalls);
+
+    StrEqualsCalls = 0;
+    for (size_t i = 0; i < keysCount; i++) {
+        int const value = Map_GetOrDefault(sut, keys[i], -1);
+        Testing_Assert((int) i == value, "expected value %zu at key %s but got %d", i, keys[i], value);
+    }
+    Testing_Assert(keysCount == StrEqualsCalls, "expected one KeyEquals call per hit but got %zu", StrEqualsCalls);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(HashCachingMap_supports_all_operations) {
+    typedef HashCachingMap(int, int) CachingIntIntMap;
+    CachingIntIntMap sut = Map_Empty(CachingIntIntMap, IntHashConst, IntEquals);
+
+    for (int i = 0; i < 50; i++) {
+        Map_Put(&sut, i, i * i);
+    }
+    for (int i = 0; i < 50; i += 2) {
+        Testing_Assert(true == Map_Remove(&sut, i), "expected key %d to be removed", i);
+    }
+
+    Testing_Assert(25 == sut.Size, "expected size to be 25 but was %zu", sut.Size);
+    size_t visited = 0;
+    Map_ForEach(entry, sut) {
+        Testing_Assert(1 == entry->Key % 2, "expected only odd keys to be left but got %d", entry->Key);
+        Testing_Assert(entry->Key * entry->Key == entry->Value, "wrong value at key %d", entry->Key);
+        visited++;
+    }
+    Testing_Assert(25 == visited, "expected ForEach to visit 25 entries but visited %zu", visited);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Map_does_not_store_hashes) {
+    typedef HashCachingMap(int, int) CachingIntIntMap;
+
+    Testing_Assert(
+        sizeof(*((IntIntMap *) NULL)->Entries) < sizeof(*((CachingIntIntMap *) NULL)->Entries),
+        "expected plain map entries to be smaller than hash caching ones");
+}
+
+Testing_Fact(Put_with_RehashStep_migrates_entries_incrementally) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    sut.RehashStep = 4;
+
+    int i = 0;
+    while (NULL == sut.OldEntries) {
+        Map_Put(&sut, i, i);
+        i++;
+    }
+
+    size_t const oldCapacity = sut.OldCapacity;
+    size_t newTableSize = 0;
+    for (size_t slot = 0; slot < sut.Capacity; slot++) {
+        newTableSize += sut.Entries[slot].Used;
+    }
+    Testing_Assert(2 * oldCapacity == sut.Capacity, "expected capacity to double");
+    Testing_Assert(newTableSize <= 1 + sut.RehashStep, "expected only a few entries to be migrated but got %zu", newTableSize);
+
+    for (int key = 0; key < i; key++) {
+        Testing_Assert(key == Map_GetOrDefault(sut, key, -1), "expected key %d to be found during migration", key);
+    }
+
+    size_t puts = 0;
+    while (NULL != sut.OldEntries) {
+        Map_Put(&sut, i, i);
+        i++;
+        puts++;
+    }
+    Testing_Assert(
+        puts <= oldCapacity / sut.RehashStep + 1,
+        "expected migration to finish after about %zu puts but took %zu", oldCapacity / sut.RehashStep, puts);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Put_with_RehashStep_keeps_all_keys_reachable) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    sut.RehashStep = 1;
+
+    int const keysCount = 5000;
+    for (int i = 0; i < keysCount; i++) {
+        Map_Put(&sut, i * 7919, i);
+        if (0 != i % 97 && NULL == sut.OldEntries) {
+            continue;
+        }
+        int const stride = NULL == sut.OldEntries ? 1 : 11;
+        for (int key = 0; key <= i; key += stride) {
+            int const value = Map_GetOrDefault(sut, key * 7919, -1);
+            Testing_Assert(key == value, "expected value %d at key %d but got %d", key, key * 7919, value);
+        }
+    }
+
+    Testing_Assert(keysCount == (int) sut.Size, "expected size to be %d but was %zu", keysCount, sut.Size);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Remove_with_RehashStep_keeps_map_consistent_under_churn) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashConst, IntEquals);
+    sut.RehashStep = 2;
+
+    bool present[200] = {0};
+    size_t expectedSize = 0;
+    size_t migratingSteps = 0;
+    unsigned state = 777;
+    for (int step = 0; step < 20000; step++) {
+        state = state * 1103515245 + 12345;
+        int const key = (int) ((state >> 8) % 200);
+        if (0 != (state & 0x30000)) {
+            expectedSize += false == present[key];
+            present[key] = true;
+            Map_Put(&sut, key, -key);
+        } else {
+            expectedSize -= present[key];
+            Testing_Assert(present[key] == Map_Remove(&sut, key), "unexpected Remove result for key %d", key);
+            present[key] = false;
+        }
+
+        if (NULL == sut.OldEntries) {
+            continue;
+        }
+        migratingSteps++;
+
+        bool visited[200] = {0};
+        size_t visitedCount = 0;
+        Map_ForEach(entry, sut) {
+            Testing_Assert(present[entry->Key], "expected key %d to be present", entry->Key);
+            Testing_Assert(false == visited[entry->Key], "expected key %d to be visited once", entry->Key);
+            visited[entry->Key] = true;
+            visitedCount++;
+        }
+        Testing_Assert(expectedSize == visitedCount, "expected ForEach to visit %zu entries but visited %zu", expectedSize, visitedCount);
+        for (int k = 0; k < 200; k++) {
+            Testing_Assert(present[k] == (NULL != Map_At(sut, k)), "unexpected presence of key %d during migration", k);
+        }
+    }
+
+    Testing_Assert(migratingSteps > 0, "expected the map to be migrated at least once");
+    Testing_Assert(expectedSize == sut.Size, "expected size to be %zu but was %zu", expectedSize, sut.Size);
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(HashCachingMap_with_RehashStep_never_rehashes_keys) {
+    typedef HashCachingMap(char const *, int) CachingStringIntMap;
+    CachingStringIntMap sut = Map_Empty(CachingStringIntMap, CountingStrHash, CountingStrEquals);
+    sut.RehashStep = 3;
+
+    static char keys[1000][8];
+    size_t const keysCount = sizeof(keys) / sizeof(keys[0]);
+    for (size_t i = 0; i < keysCount; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+    }
+
+    StrHashCalls = 0;
+    for (size_t i = 0; i < keysCount; i++) {
+        Map_Put(&sut, keys[i], (int) i);
+    }
+    Testing_Assert(keysCount == StrHashCalls, "expected one Hash call per Put but got %zu", StrHashCalls);
+
+    Map_Reserve(&sut, 4 * keysCount);
+    Testing_Assert(NULL == sut.OldEntries, "expected Reserve to finish migration");
+    for (size_t i = 0; i < keysCount; i++) {
+        Testing_Assert((int) i == Map_GetOrDefault(sut, keys[i], -1), "expected key %s to be found", keys[i]);
+    }
+
+    Map_Free(&sut);
+    Testing_Assert(3 == sut.RehashStep, "expected Free to keep RehashStep");
+}
+
+static bool OccupiedBitmapMatchesEntries(IntIntMap const *map) {
+    for (size_t i = 0; i < map->Capacity; i++) {
+        bool const bit = MAP__Occupied(map->Entries, map->Capacity)[i / 64] >> (i % 64) & 1;
+        if (bit != map->Entries[i].Used) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < map->OldCapacity; i++) {
+        bool const bit = MAP__Occupied(map->OldEntries, map->OldCapacity)[i / 64] >> (i % 64) & 1;
+        if (bit != map->OldEntries[i].Used) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Testing_Fact(Occupied_bitmap_tracks_used_entries) {
+    size_t const rehashSteps[] = {0, 3};
+    for (size_t r = 0; r < sizeof(rehashSteps) / sizeof(rehashSteps[0]); r++) {
+        IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+        sut.RehashStep = rehashSteps[r];
+
+        unsigned state = 99;
+        for (int step = 0; step < 5000; step++) {
+            state = state * 1103515245 + 12345;
+            int const key = (int) ((state >> 8) % 300);
+            if (state & 0x30000) {
+                Map_Put(&sut, key, key);
+            } else {
+                Map_Remove(&sut, key);
+            }
+            if (0 == step % 10 || NULL != sut.OldEntries) {
+                Testing_Assert(
+                    OccupiedBitmapMatchesEntries(&sut),
+                    "expected bitmap to match entries after step %d with RehashStep %zu", step, sut.RehashStep);
+            }
+        }
+
+        Map_Free(&sut);
+    }
+}
+
+Testing_Fact(ForEach_visits_only_remaining_entries_of_sparse_map) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 10000; i++) {
+        Map_Put(&sut, i, i);
+    }
+    for (int i = 0; i < 10000; i++) {
+        if (i != 0 && i != 63 && i != 9999) {
+            Map_Remove(&sut, i);
+        }
+    }
+
+    int sum = 0;
+    size_t visited = 0;
+    Map_ForEach(entry, sut) {
+        sum += entry->Key;
+        visited++;
+    }
+
+    Testing_Assert(3 == visited, "expected ForEach to visit 3 entries but visited %zu", visited);
+    Testing_Assert(0 + 63 + 9999 == sum, "expected ForEach to visit the remaining keys");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(TryPut_only_inserts_missing_keys) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    int evaluated = 0;
+    Testing_Assert(true == Map_TryPut(&sut, 1, ++evaluated), "expected TryPut to insert missing key");
+    Testing_Assert(false == Map_TryPut(&sut, 1, ++evaluated), "expected TryPut to not insert existing key");
+
+    Testing_Assert(1 == evaluated, "expected value to only be evaluated when inserting");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+    Testing_Assert(1 == Map_GetOrDefault(sut, 1, -1), "expected existing value to be kept");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(GetOrInsert_returns_existing_value_or_inserts_default) {
+    StringIntMap sut = Map_Empty(StringIntMap, StrHash, StrEquals);
+
+    char const *words[] = {"a", "b", "a", "c", "b", "a"};
+    size_t const wordsCount = sizeof(words) / sizeof(words[0]);
+    size_t inserted = 0;
+    for (size_t i = 0; i < wordsCount; i++) {
+        __auto_type result = Map_GetOrInsert(&sut, words[i], 0);
+        *result.Value += 1;
+        inserted += result.Inserted;
+    }
+
+    Testing_Assert(3 == inserted, "expected 3 insertions but got %zu", inserted);
+    Testing_Assert(3 == sut.Size, "expected size to be 3 but was %zu", sut.Size);
+    Testing_Assert(3 == Map_GetOrDefault(sut, "a", -1), "expected word a to be counted 3 times");
+    Testing_Assert(2 == Map_GetOrDefault(sut, "b", -1), "expected word b to be counted 2 times");
+    Testing_Assert(1 == Map_GetOrDefault(sut, "c", -1), "expected word c to be counted once");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(GetOrInsert_only_evaluates_default_expression_if_key_does_not_exist) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    Map_Put(&sut, 1, 10);
+
+    int evaluated = 0;
+    __auto_type existing = Map_GetOrInsert(&sut, 1, ++evaluated);
+    Testing_Assert(false == existing.Inserted, "expected existing key to not be inserted");
+    Testing_Assert(10 == *existing.Value, "expected existing value but got %d", *existing.Value);
+    Testing_Assert(0 == evaluated, "expected default to not be evaluated for existing key");
+
+    __auto_type missing = Map_GetOrInsert(&sut, 2, ++evaluated);
+    Testing_Assert(true == missing.Inserted, "expected missing key to be inserted");
+    Testing_Assert(1 == *missing.Value, "expected default value but got %d", *missing.Value);
+    Testing_Assert(1 == evaluated, "expected default to be evaluated once for missing key");
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(Put_TryPut_and_GetOrInsert_hash_and_compare_key_once) {
+    typedef HashCachingMap(char const *, int) CachingStringIntMap;
+    CachingStringIntMap sut = Map_Empty(CachingStringIntMap, CountingStrHash, CountingStrEquals);
+
+    static char keys[100][8];
+    size_t const keysCount = sizeof(keys) / sizeof(keys[0]);
+    for (size_t i = 0; i < keysCount; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+        Map_Put(&sut, keys[i], (int) i);
+    }
+
+    StrHashCalls = 0;
+    StrEqualsCalls = 0;
+    for (size_t i = 0; i < keysCount; i++) {
+        Map_Put(&sut, keys[i], (int) i + 1);
+        Map_TryPut(&sut, keys[i], 0);
+        *Map_GetOrInsert(&sut, keys[i], 0).Value += 1;
+    }
+
+    Testing_Assert(3 * keysCount == StrHashCalls, "expected one Hash call per operation but got %zu", StrHashCalls);
+    Testing_Assert(3 * keysCount == StrEqualsCalls, "expected one KeyEquals call per operation but got %zu", StrEqualsCalls);
+    for (size_t i = 0; i < keysCount; i++) {
+        Testing_Assert((int) i + 2 == Map_GetOrDefault(sut, keys[i], -1), "wrong value at key %s", keys[i]);
+    }
+
+    Map_Free(&sut);
+}
+
+Testing_Fact(GetOrInsert_with_RehashStep_finds_keys_in_both_tables) {
+    IntIntMap sut = Map_Empty(IntIntMap, IntHashConst, IntEquals);
+    sut.RehashStep = 1;
+
+    int const keysCount = 300;
+    size_t migratingSteps = 0;
+    for (int i = 0; i < keysCount; i++) {
+        Map_Put(&sut, i, i);
+        migratingSteps += NULL != sut.OldEntries;
+        for (int key = 0; key <= i; key += 37) {
+            __auto_type result = Map_GetOrInsert(&sut, key, -1);
+            Testing_Assert(false == result.Inserted, "expected key %d to be found", key);
+            Testing_Assert(key == *result.Value, "expected value %d at key %d but got %d", key, key, *result.Value);
+        }
+    }
+
+    Testing_Assert(migratingSteps > 0, "expected the map to be migrated at least once");
+    Testing_Assert(keysCount == (int) sut.Size, "expected size to be %d but was %zu", keysCount, sut.Size);
+
+    Map_Free(&sut);
+}
+
 Testing_Fact(IsEmpty_returns_true_for_empty_map) {
     IntIntMap sut = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
 
@@ -393,6 +1054,22 @@ Testing_Fact(IsEmpty_returns_false_for_non_empty_map) {
     Map_Free(&sut);
 }
 
+Testing_Fact(Put_keeps_over_aligned_values_aligned) {
+    typedef struct { alignas(64) int Value; } AlignedInt;
+    typedef Map(int, AlignedInt) IntAlignedMap;
+    IntAlignedMap sut = Map_Empty(IntAlignedMap, NULL, NULL);
+
+    for (int i = 0; i < 100; i++) {
+        AlignedInt *value = Map_Put(&sut, i, ((AlignedInt) {.Value = i}));
+        Testing_Assert(0 == (uintptr_t) value % 64, "expected value to be 64-byte aligned");
+    }
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(i == Map_At(sut, i)->Value, "expected %d at key %d", i, i);
+    }
+
+    Map_Free(&sut);
+}
+
 Testing_AllTests = {
         Testing_AddTest(Empty_returns_map_with_Size_set_to_0),
         Testing_AddTest(Of_creates_a_map_with_given_key_value_pairs),
@@ -400,6 +1077,13 @@ Testing_AllTests = {
         Testing_AddTest(Put_handles_collisions_with_constant_hash),
         Testing_AddTest(Put_overwrites_values_if_called_with_same_key),
         Testing_AddTest(Put_only_updates_key_when_it_is_first_inserted),
+        Testing_AddTest(Put_keeps_capacity_a_power_of_two),
+        Testing_AddTest(Put_handles_hashes_differing_only_in_high_bits),
+        Testing_AddTest(Put_fills_table_up_to_seven_eighths_before_growing),
+        Testing_AddTest(Put_stores_distance_of_each_entry_from_its_home_slot),
+        Testing_AddTest(Empty_uses_default_functions_for_integer_keys_when_given_NULL),
+        Testing_AddTest(Empty_uses_default_functions_for_string_keys_when_given_NULL),
+        Testing_AddTest(Of_accepts_NULL_functions),
         Testing_AddTest(Size_is_equal_to_number_of_distinct_keys_inserted),
         Testing_AddTest(Size_is_not_increased_when_Put_is_called_with_existing_key),
         Testing_AddTest(TryGet_returns_false_for_empty_map),
@@ -413,8 +1097,31 @@ Testing_AllTests = {
         Testing_AddTest(GetOrDefault_returns_default_if_key_does_not_exist),
         Testing_AddTest(ForEach_never_executes_body_for_empty_list),
         Testing_AddTest(ForEach_iterates_over_all_elements),
+        Testing_AddTest(Remove_returns_false_if_key_does_not_exist),
+        Testing_AddTest(Remove_deletes_key_and_decreases_size),
+        Testing_AddTest(Remove_keeps_colliding_keys_reachable),
+        Testing_AddTest(Remove_keeps_map_consistent_under_churn),
+        Testing_AddTest(Reserve_allows_inserting_expected_count_without_growing),
+        Testing_AddTest(Reserve_keeps_entries_and_never_shrinks),
+        Testing_AddTest(PutAllFromPtr_inserts_all_entries_with_later_ones_winning),
+        Testing_AddTest(PutAll_inserts_items_of_a_span_in_one_allocation),
+        Testing_AddTest(HashCachingMap_never_rehashes_keys_when_growing),
+        Testing_AddTest(HashCachingMap_supports_all_operations),
+        Testing_AddTest(Map_does_not_store_hashes),
+        Testing_AddTest(Put_with_RehashStep_migrates_entries_incrementally),
+        Testing_AddTest(Put_with_RehashStep_keeps_all_keys_reachable),
+        Testing_AddTest(Remove_with_RehashStep_keeps_map_consistent_under_churn),
+        Testing_AddTest(HashCachingMap_with_RehashStep_never_rehashes_keys),
+        Testing_AddTest(Occupied_bitmap_tracks_used_entries),
+        Testing_AddTest(ForEach_visits_only_remaining_entries_of_sparse_map),
+        Testing_AddTest(TryPut_only_inserts_missing_keys),
+        Testing_AddTest(GetOrInsert_returns_existing_value_or_inserts_default),
+        Testing_AddTest(GetOrInsert_only_evaluates_default_expression_if_key_does_not_exist),
+        Testing_AddTest(Put_TryPut_and_GetOrInsert_hash_and_compare_key_once),
+        Testing_AddTest(GetOrInsert_with_RehashStep_finds_keys_in_both_tables),
         Testing_AddTest(IsEmpty_returns_true_for_empty_map),
         Testing_AddTest(IsEmpty_returns_false_for_non_empty_map),
+        Testing_AddTest(Put_keeps_over_aligned_values_aligned),
 };
 
 Testing_RunAllTests();
\ No newline at end of file
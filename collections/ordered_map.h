@@ -0,0 +1,381 @@
+#ifndef ORDERED_MAP_H
+#define ORDERED_MAP_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
+#include "hash.h"
+#include "map.h"
+
+// A map that keeps its entries in insertion order, laid out like CPython's
+// dict. Entries are appended to a dense array, and a separate
+// open-addressing index of uint32_t slots maps hashes to positions in that
+// array. An empty slot costs 4 bytes instead of a whole entry, and
+// iteration runs over contiguous memory.
+//
+// Removing a key unlinks it from the index and marks its entry as removed,
+// which keeps the order of the other entries. Removed entries are dropped
+// when the array fills up and the map is rebuilt.
+
+#define ORDERED_MAP__CallChecked(Callee, ArgsList)  \
+({                                                  \
+    errno = 0;                                      \
+    __auto_type _r = Callee ArgsList;               \
+    if (errno) {                                    \
+        fprintf(                                    \
+            stderr, "[%s:%d] %s%s: %s\n",           \
+            __FILE_NAME__, __LINE__,                \
+            #Callee, #ArgsList,                     \
+            strerror(errno)                         \
+        );                                          \
+        exit(EXIT_FAILURE);                         \
+    }                                               \
+    _r;                                             \
+})
+
+// IndexCapacity is always zero or a power of two.
+#define ORDERED_MAP_INITIAL_INDEX_CAPACITY 8
+
+#define OrderedMap(TKey, TValue)            \
+struct {                                    \
+    size_t Size;                            \
+    size_t Count;                           \
+    size_t Capacity;                        \
+    size_t IndexCapacity;                   \
+    size_t (*Hash)(TKey);                   \
+    bool (*KeyEquals)(TKey, TKey);          \
+    struct {                                \
+        TKey Key;                           \
+        TValue Value;                       \
+        size_t Hash;                        \
+    } *Entries;                             \
+    uint32_t *Index;                        \
+    Allocator Allocator;                    \
+}
+
+// Stored hashes always have their top bit set, so that a zero hash marks
+// a removed entry. Index slots are selected by the low bits only.
+#define ORDERED_MAP__LIVE ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
+#define ORDERED_MAP__HashOf(Map_, Key_) (MAP__HashOf((Map_), (Key_)) | ORDERED_MAP__LIVE)
+
+// The entry array holds three entries for every four index slots, so the
+// index is at most three quarters full.
+#define ORDERED_MAP__CapacityFor(IndexCapacity_) ((IndexCapacity_) / 4 * 3)
+
+#define OrderedMap_Empty(MapType, Hash_, KeyEquals_) ((MapType) {.Hash = (Hash_), .KeyEquals = (KeyEquals_)})
+
+#define OrderedMap_WithAllocator(MapType, Hash_, KeyEquals_, Allocator_)    \
+((MapType) {                                                                \
+    .Hash = (Hash_),                                                        \
+    .KeyEquals = (KeyEquals_),                                              \
+    .Allocator = (Allocator_),                                              \
+})
+
+#define ORDERED_MAP__WithEntries(Map_, ...)                                                 \
+({                                                                                          \
+    __auto_type _ordered_with_entries = (Map_);                                             \
+    typeof(_ordered_with_entries.Entries[0]) _newEntries[] = {__VA_ARGS__};                 \
+    for (size_t _i_with_entries = 0;                                                        \
+         _i_with_entries < MAP__ArrayLength(_newEntries);                                   \
+         _i_with_entries++) {                                                               \
+        OrderedMap_Put(                                                                     \
+            &_ordered_with_entries,                                                         \
+            _newEntries[_i_with_entries].Key,                                               \
+            _newEntries[_i_with_entries].Value);                                            \
+    }                                                                                       \
+    _ordered_with_entries;                                                                  \
+})
+
+#define OrderedMap_Of(MapType, Hash_, KeyEquals_, ...) \
+    ORDERED_MAP__WithEntries(OrderedMap_Empty(MapType, Hash_, KeyEquals_), ##__VA_ARGS__)
+
+#define OrderedMap_Free(MapPtr)                                             \
+do {                                                                        \
+    __auto_type _ordered_ptr_free = (MapPtr);                               \
+    if (NULL != _ordered_ptr_free->Entries) {                               \
+        Allocator_Free(                                                     \
+            _ordered_ptr_free->Allocator,                                   \
+            _ordered_ptr_free->Entries,                                     \
+            _ordered_ptr_free->Capacity                                     \
+                * sizeof(*_ordered_ptr_free->Entries));                     \
+        Allocator_Free(                                                     \
+            _ordered_ptr_free->Allocator,                                   \
+            _ordered_ptr_free->Index,                                       \
+            _ordered_ptr_free->IndexCapacity * sizeof(uint32_t));           \
+    }                                                                       \
+    *_ordered_ptr_free = OrderedMap_WithAllocator(                          \
+        typeof(*_ordered_ptr_free),                                         \
+        _ordered_ptr_free->Hash,                                            \
+        _ordered_ptr_free->KeyEquals,                                       \
+        _ordered_ptr_free->Allocator                                        \
+    );                                                                      \
+} while (0)
+
+// Return the index slot that refers to the entry with Key_ and stored
+// hash Hash_, or the empty slot where the probe for it stopped. The index
+// must not be empty.
+#define ORDERED_MAP__Probe(Map_, Key_, Hash_)                                      \
+({                                                                                 \
+    __auto_type _ordered_probe = (Map_);                                           \
+    size_t const _hash_probe = (Hash_);                                            \
+    size_t const _mask_probe = _ordered_probe.IndexCapacity - 1;                   \
+    size_t _slot_probe = _hash_probe & _mask_probe;                                \
+    for (;;) {                                                                     \
+        uint32_t const _position_probe = _ordered_probe.Index[_slot_probe];        \
+        if (0 == _position_probe) {                                                \
+            break;                                                                 \
+        }                                                                          \
+        __auto_type _entry_probe = &(_ordered_probe.Entries[_position_probe - 1]); \
+        if (                                                                       \
+            _hash_probe == _entry_probe->Hash                                      \
+            && MAP__KeysEqual(_ordered_probe, (Key_), _entry_probe->Key)           \
+        ) {                                                                        \
+            break;                                                                 \
+        }                                                                          \
+        _slot_probe = (_slot_probe + 1) & _mask_probe;                             \
+    }                                                                              \
+    _slot_probe;                                                                   \
+})
+
+#define ORDERED_MAP__Find(Map_, Key_)                                                  \
+({                                                                                     \
+    __auto_type _ordered_find = (Map_);                                                \
+    typeof(_ordered_find.Entries) _found_find = NULL;                                  \
+    if (_ordered_find.Size > 0) {                                                      \
+        typeof(_ordered_find.Entries->Key) _key_find = (Key_);                         \
+        uint32_t const _position_find = _ordered_find.Index[ORDERED_MAP__Probe(        \
+            _ordered_find, _key_find, ORDERED_MAP__HashOf(_ordered_find, _key_find))]; \
+        if (0 != _position_find) {                                                     \
+            _found_find = &(_ordered_find.Entries[_position_find - 1]);                \
+        }                                                                              \
+    }                                                                                  \
+    _found_find;                                                                       \
+})
+
+// Move the live entries to the front of an array with room for at least
+// one more entry, and rebuild the index from the stored hashes, without
+// calling Hash or KeyEquals. The arrays double when at least half of the
+// entries are live; otherwise dropping the removed ones makes enough room.
+#define ORDERED_MAP__Rebuild(MapPtr)                                                      \
+do {                                                                                      \
+    __auto_type _ordered_ptr_rebuild = (MapPtr);                                          \
+    size_t _indexCapacity_rebuild = _ordered_ptr_rebuild->IndexCapacity;                  \
+    if (0 == _indexCapacity_rebuild) {                                                    \
+        _indexCapacity_rebuild = ORDERED_MAP_INITIAL_INDEX_CAPACITY;                      \
+    } else if (2 * _ordered_ptr_rebuild->Size >= _ordered_ptr_rebuild->Capacity) {        \
+        _indexCapacity_rebuild *= 2;                                                      \
+    }                                                                                     \
+    size_t const _capacity_rebuild = ORDERED_MAP__CapacityFor(_indexCapacity_rebuild);    \
+    if (_capacity_rebuild >= UINT32_MAX) {                                                \
+        fprintf(                                                                          \
+            stderr, "[%s:%d] OrderedMap: too many entries\n",                             \
+            __FILE_NAME__, __LINE__                                                       \
+        );                                                                                \
+        exit(EXIT_FAILURE);                                                               \
+    }                                                                                     \
+    __auto_type _entries_rebuild = _ordered_ptr_rebuild->Entries;                         \
+    if (_capacity_rebuild != _ordered_ptr_rebuild->Capacity) {                            \
+        _entries_rebuild = ORDERED_MAP__CallChecked(                                      \
+            Allocator_Allocate, (                                                         \
+                _ordered_ptr_rebuild->Allocator,                                          \
+                _capacity_rebuild * sizeof(*_entries_rebuild),                            \
+                alignof(typeof(*_entries_rebuild))                                        \
+            ));                                                                           \
+    }                                                                                     \
+    size_t _count_rebuild = 0;                                                            \
+    for (size_t _i_rebuild = 0; _i_rebuild < _ordered_ptr_rebuild->Count; _i_rebuild++) { \
+        if (0 != _ordered_ptr_rebuild->Entries[_i_rebuild].Hash) {                        \
+            _entries_rebuild[_count_rebuild++] =                                          \
+                _ordered_ptr_rebuild->Entries[_i_rebuild];                                \
+        }                                                                                 \
+    }                                                                                     \
+    if (_entries_rebuild != _ordered_ptr_rebuild->Entries) {                              \
+        if (NULL != _ordered_ptr_rebuild->Entries) {                                      \
+            Allocator_Free(                                                               \
+                _ordered_ptr_rebuild->Allocator,                                          \
+                _ordered_ptr_rebuild->Entries,                                            \
+                _ordered_ptr_rebuild->Capacity * sizeof(*_entries_rebuild));              \
+            Allocator_Free(                                                               \
+                _ordered_ptr_rebuild->Allocator,                                          \
+                _ordered_ptr_rebuild->Index,                                              \
+                _ordered_ptr_rebuild->IndexCapacity * sizeof(uint32_t));                  \
+        }                                                                                 \
+        _ordered_ptr_rebuild->Index = ORDERED_MAP__CallChecked(                           \
+            Allocator_Allocate, (                                                         \
+                _ordered_ptr_rebuild->Allocator,                                          \
+                _indexCapacity_rebuild * sizeof(uint32_t),                                \
+                alignof(uint32_t)                                                         \
+            ));                                                                           \
+    }                                                                                     \
+    memset(_ordered_ptr_rebuild->Index, 0, _indexCapacity_rebuild * sizeof(uint32_t));    \
+    size_t const _mask_rebuild = _indexCapacity_rebuild - 1;                              \
+    for (size_t _i_rebuild = 0; _i_rebuild < _count_rebuild; _i_rebuild++) {              \
+        size_t _slot_rebuild = _entries_rebuild[_i_rebuild].Hash & _mask_rebuild;         \
+        while (0 != _ordered_ptr_rebuild->Index[_slot_rebuild]) {                         \
+            _slot_rebuild = (_slot_rebuild + 1) & _mask_rebuild;                          \
+        }                                                                                 \
+        _ordered_ptr_rebuild->Index[_slot_rebuild] = (uint32_t) _i_rebuild + 1;           \
+    }                                                                                     \
+    _ordered_ptr_rebuild->Entries = _entries_rebuild;                                     \
+    _ordered_ptr_rebuild->Capacity = _capacity_rebuild;                                   \
+    _ordered_ptr_rebuild->IndexCapacity = _indexCapacity_rebuild;                         \
+    _ordered_ptr_rebuild->Count = _count_rebuild;                                         \
+    _ordered_ptr_rebuild->Size = _count_rebuild;                                          \
+} while (0)
+
+// Return a pointer to the entry with Key_, appending one with an
+// uninitialized value if the key is absent, and set *InsertedPtr to
+// whether it did.
+#define ORDERED_MAP__Upsert(MapPtr, Key_, InsertedPtr)                                    \
+({                                                                                        \
+    __auto_type _ordered_ptr_upsert = (MapPtr);                                           \
+    typeof(_ordered_ptr_upsert->Entries->Key) _key_upsert = (Key_);                       \
+    size_t const _hash_upsert = ORDERED_MAP__HashOf(*_ordered_ptr_upsert, _key_upsert);   \
+    typeof(_ordered_ptr_upsert->Entries) _entry_upsert = NULL;                            \
+    if (_ordered_ptr_upsert->Size > 0) {                                                  \
+        uint32_t const _position_upsert = _ordered_ptr_upsert->Index[ORDERED_MAP__Probe(  \
+            *_ordered_ptr_upsert, _key_upsert, _hash_upsert)];                            \
+        if (0 != _position_upsert) {                                                      \
+            _entry_upsert = &(_ordered_ptr_upsert->Entries[_position_upsert - 1]);        \
+        }                                                                                 \
+    }                                                                                     \
+    *(InsertedPtr) = NULL == _entry_upsert;                                               \
+    if (NULL == _entry_upsert) {                                                          \
+        if (_ordered_ptr_upsert->Count == _ordered_ptr_upsert->Capacity) {                \
+            ORDERED_MAP__Rebuild(_ordered_ptr_upsert);                                    \
+        }                                                                                 \
+        size_t const _mask_upsert = _ordered_ptr_upsert->IndexCapacity - 1;               \
+        size_t _slot_upsert = _hash_upsert & _mask_upsert;                                \
+        while (0 != _ordered_ptr_upsert->Index[_slot_upsert]) {                           \
+            _slot_upsert = (_slot_upsert + 1) & _mask_upsert;                             \
+        }                                                                                 \
+        _entry_upsert = &(_ordered_ptr_upsert->Entries[_ordered_ptr_upsert->Count]);      \
+        _entry_upsert->Key = _key_upsert;                                                 \
+        _entry_upsert->Hash = _hash_upsert;                                               \
+        _ordered_ptr_upsert->Count += 1;                                                  \
+        _ordered_ptr_upsert->Index[_slot_upsert] = (uint32_t) _ordered_ptr_upsert->Count; \
+        _ordered_ptr_upsert->Size += 1;                                                   \
+    }                                                                                     \
+    _entry_upsert;                                                                        \
+})
+
+#define OrderedMap_Put(MapPtr, Key_, Value_)                            \
+({                                                                      \
+    bool _inserted_ordered_put;                                         \
+    __auto_type _slot_ordered_put =                                     \
+        ORDERED_MAP__Upsert((MapPtr), (Key_), &_inserted_ordered_put);  \
+    _slot_ordered_put->Value = (Value_);                                \
+    &(_slot_ordered_put->Value);                                        \
+})
+
+#define OrderedMap_At(Map_, Key_)                                       \
+({                                                                      \
+    __auto_type _slot_ordered_at = ORDERED_MAP__Find((Map_), (Key_));   \
+    (NULL == _slot_ordered_at ? NULL : &_slot_ordered_at->Value);       \
+})
+
+#define OrderedMap_TryGet(Map_, Key_, ValuePtr)                             \
+({                                                                          \
+    __auto_type _value_ordered_try_get = OrderedMap_At((Map_), (Key_));     \
+    if (NULL != _value_ordered_try_get) {                                   \
+        *(ValuePtr) = *_value_ordered_try_get;                              \
+    }                                                                       \
+    NULL != _value_ordered_try_get;                                         \
+})
+
+#define OrderedMap_GetOrDefault(Map_, Key_, DefaultExpr)                            \
+({                                                                                  \
+    typeof((Map_).Entries->Value) _value_ordered_or_default;                        \
+    if (false == OrderedMap_TryGet((Map_), (Key_), &_value_ordered_or_default)) {   \
+        _value_ordered_or_default = (DefaultExpr);                                  \
+    }                                                                               \
+    _value_ordered_or_default;                                                      \
+})
+
+// Clear the index slot Slot by shifting the rest of its probe run back,
+// so the index never holds tombstones. An entry moves into the hole
+// unless its home slot lies after the hole.
+#define ORDERED_MAP__Unlink(MapPtr, Slot)                                                      \
+do {                                                                                           \
+    __auto_type _ordered_ptr_unlink = (MapPtr);                                                \
+    size_t const _mask_unlink = _ordered_ptr_unlink->IndexCapacity - 1;                        \
+    size_t _hole_unlink = (Slot);                                                              \
+    size_t _next_unlink = (_hole_unlink + 1) & _mask_unlink;                                   \
+    while (0 != _ordered_ptr_unlink->Index[_next_unlink]) {                                    \
+        size_t const _home_unlink = _mask_unlink                                               \
+            & _ordered_ptr_unlink->Entries[_ordered_ptr_unlink->Index[_next_unlink] - 1].Hash; \
+        if (                                                                                   \
+            ((_next_unlink - _home_unlink) & _mask_unlink)                                     \
+            >= ((_next_unlink - _hole_unlink) & _mask_unlink)                                  \
+        ) {                                                                                    \
+            _ordered_ptr_unlink->Index[_hole_unlink] =                                         \
+                _ordered_ptr_unlink->Index[_next_unlink];                                      \
+            _hole_unlink = _next_unlink;                                                       \
+        }                                                                                      \
+        _next_unlink = (_next_unlink + 1) & _mask_unlink;                                      \
+    }                                                                                          \
+    _ordered_ptr_unlink->Index[_hole_unlink] = 0;                                              \
+} while (0)
+
+// Removed entries at the end of the array are reused right away.
+#define OrderedMap_Remove(MapPtr, Key_)                                                   \
+({                                                                                        \
+    __auto_type _ordered_ptr_remove = (MapPtr);                                           \
+    bool _removed_remove = false;                                                         \
+    if (_ordered_ptr_remove->Size > 0) {                                                  \
+        typeof(_ordered_ptr_remove->Entries->Key) _key_remove = (Key_);                   \
+        size_t const _slot_remove = ORDERED_MAP__Probe(                                   \
+            *_ordered_ptr_remove, _key_remove,                                            \
+            ORDERED_MAP__HashOf(*_ordered_ptr_remove, _key_remove));                      \
+        uint32_t const _position_remove = _ordered_ptr_remove->Index[_slot_remove];       \
+        if (0 != _position_remove) {                                                      \
+            ORDERED_MAP__Unlink(_ordered_ptr_remove, _slot_remove);                       \
+            _ordered_ptr_remove->Entries[_position_remove - 1].Hash = 0;                  \
+            _ordered_ptr_remove->Size -= 1;                                               \
+            while (                                                                       \
+                _ordered_ptr_remove->Count > 0                                            \
+                && 0 == _ordered_ptr_remove->Entries[_ordered_ptr_remove->Count - 1].Hash \
+            ) {                                                                           \
+                _ordered_ptr_remove->Count -= 1;                                          \
+            }                                                                             \
+            _removed_remove = true;                                                       \
+        }                                                                                 \
+    }                                                                                     \
+    _removed_remove;                                                                      \
+})
+
+#define ORDERED_MAP__SkipRemoved(EntryPtr, End)                 \
+({                                                              \
+    __auto_type _entry_skip = (EntryPtr);                       \
+    __auto_type _end_skip = (End);                              \
+    while (_entry_skip < _end_skip && 0 == _entry_skip->Hash) { \
+        _entry_skip++;                                          \
+    }                                                           \
+    _entry_skip;                                                \
+})
+
+#define OrderedMap_ForEach(EntryPtr, Map_)                                                          \
+__auto_type MAP__Concat(_ordered_for_each_, __LINE__) = (Map_);                                     \
+for (                                                                                               \
+    typeof(MAP__Concat(_ordered_for_each_, __LINE__).Entries) EntryPtr = ORDERED_MAP__SkipRemoved(  \
+        MAP__Concat(_ordered_for_each_, __LINE__).Entries,                                          \
+        MAP__Concat(_ordered_for_each_, __LINE__).Entries                                           \
+            + MAP__Concat(_ordered_for_each_, __LINE__).Count);                                     \
+    EntryPtr < MAP__Concat(_ordered_for_each_, __LINE__).Entries                                    \
+        + MAP__Concat(_ordered_for_each_, __LINE__).Count;                                          \
+    EntryPtr = ORDERED_MAP__SkipRemoved(                                                            \
+        EntryPtr + 1,                                                                               \
+        MAP__Concat(_ordered_for_each_, __LINE__).Entries                                           \
+            + MAP__Concat(_ordered_for_each_, __LINE__).Count)                                      \
+)
+
+#define OrderedMap_IsEmpty(Map_) (0 == (Map_).Size)
+
+#endif // ORDERED_MAP_H
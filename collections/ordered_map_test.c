@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "ordered_map.h"
+
+#include "testing/testing.h"
+
+typedef OrderedMap(int, int) IntIntOrderedMap;
+typedef OrderedMap(char const *, int) StringIntOrderedMap;
+typedef Map(int, int) IntIntMap;
+
+size_t IntHashIdentity(int value) {
+    return (size_t) value;
+}
+
+size_t IntHashConst(int unused) {
+    (void) unused;
+    return 42;
+}
+
+bool IntEquals(int a, int b) { return a == b; }
+
+Testing_Fact(Put_At_and_Remove_work_like_Map) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashIdentity, IntEquals);
+
+    Testing_Assert(OrderedMap_IsEmpty(sut), "expected new map to be empty");
+    Testing_Assert(NULL == OrderedMap_At(sut, 1), "expected empty map to have no keys");
+    Testing_Assert(false == OrderedMap_Remove(&sut, 1), "expected empty map to have nothing to remove");
+
+    *OrderedMap_Put(&sut, 1, 10) += 1;
+    OrderedMap_Put(&sut, 2, 20);
+    Testing_Assert(11 == *OrderedMap_At(sut, 1), "expected Put to return a pointer to the value");
+    Testing_Assert(2 == sut.Size, "expected size to be 2 but was %zu", sut.Size);
+
+    int value = 0;
+    Testing_Assert(OrderedMap_TryGet(sut, 2, &value), "expected key 2 to be found");
+    Testing_Assert(20 == value, "expected value 20 but got %d", value);
+    Testing_Assert(-1 == OrderedMap_GetOrDefault(sut, 3, -1), "expected missing key to not be found");
+
+    Testing_Assert(true == OrderedMap_Remove(&sut, 1), "expected existing key to be removed");
+    Testing_Assert(false == OrderedMap_Remove(&sut, 1), "expected removed key to not be found");
+    Testing_Assert(NULL == OrderedMap_At(sut, 1), "expected removed key to be gone");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+
+    OrderedMap_Free(&sut);
+    Testing_Assert(OrderedMap_IsEmpty(sut), "expected freed map to be empty");
+    Testing_Assert(IntHashIdentity == sut.Hash, "expected freed map to keep its functions");
+}
+
+Testing_Fact(ForEach_visits_entries_in_insertion_order) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, NULL, NULL);
+    int const keysCount = 1000;
+    for (int i = 0; i < keysCount; i++) {
+        OrderedMap_Put(&sut, (i * 7919) % keysCount, i);
+    }
+
+    int expected = 0;
+    OrderedMap_ForEach(entry, sut) {
+        Testing_Assert(expected == entry->Value, "expected value %d but got %d", expected, entry->Value);
+        Testing_Assert((expected * 7919) % keysCount == entry->Key, "wrong key at position %d", expected);
+        expected++;
+    }
+    Testing_Assert(keysCount == expected, "expected %d entries to be visited but got %d", keysCount, expected);
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Put_of_existing_key_keeps_its_position) {
+    IntIntOrderedMap sut = OrderedMap_Of(
+        IntIntOrderedMap, NULL, NULL,
+        {.Key = 3, .Value = 0},
+        {.Key = 1, .Value = 0},
+        {.Key = 2, .Value = 0},
+    );
+    OrderedMap_Put(&sut, 1, 100);
+
+    int const expectedKeys[] = {3, 1, 2};
+    size_t i = 0;
+    OrderedMap_ForEach(entry, sut) {
+        Testing_Assert(expectedKeys[i] == entry->Key, "expected key %d at %zu but got %d", expectedKeys[i], i, entry->Key);
+        i++;
+    }
+    Testing_Assert(100 == OrderedMap_GetOrDefault(sut, 1, -1), "expected value to be updated");
+    Testing_Assert(3 == sut.Size, "expected size to be 3 but was %zu", sut.Size);
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Remove_keeps_order_of_remaining_entries) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 10; i++) {
+        OrderedMap_Put(&sut, i, i);
+    }
+    for (int i = 0; i < 10; i += 3) {
+        OrderedMap_Remove(&sut, i);
+    }
+    OrderedMap_Put(&sut, 0, 0);
+
+    int const expectedKeys[] = {1, 2, 4, 5, 7, 8, 0};
+    size_t i = 0;
+    OrderedMap_ForEach(entry, sut) {
+        Testing_Assert(i < MAP__ArrayLength(expectedKeys), "expected only %zu entries", MAP__ArrayLength(expectedKeys));
+        Testing_Assert(expectedKeys[i] == entry->Key, "expected key %d at %zu but got %d", expectedKeys[i], i, entry->Key);
+        i++;
+    }
+    Testing_Assert(MAP__ArrayLength(expectedKeys) == i, "expected %zu entries but got %zu", MAP__ArrayLength(expectedKeys), i);
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Remove_keeps_colliding_keys_reachable) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashConst, IntEquals);
+    for (int i = 0; i < 20; i++) {
+        OrderedMap_Put(&sut, i, i);
+    }
+
+    for (int i = 0; i < 20; i += 2) {
+        Testing_Assert(OrderedMap_Remove(&sut, i), "expected key %d to be removed", i);
+    }
+
+    for (int i = 0; i < 20; i++) {
+        int const expected = i % 2 == 0 ? -1 : i;
+        int const value = OrderedMap_GetOrDefault(sut, i, -1);
+        Testing_Assert(expected == value, "expected value %d at key %d but got %d", expected, i, value);
+    }
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Put_reuses_space_of_removed_entries) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 100; i++) {
+        OrderedMap_Put(&sut, i, i);
+    }
+
+    for (int i = 100; i < 10000; i++) {
+        OrderedMap_Remove(&sut, i - 100);
+        OrderedMap_Put(&sut, i, i);
+    }
+
+    Testing_Assert(sut.Capacity <= 4 * sut.Size, "expected removed entries to be reused but capacity is %zu", sut.Capacity);
+    Testing_Assert(100 == sut.Size, "expected size to be 100 but was %zu", sut.Size);
+    int expected = 9900;
+    OrderedMap_ForEach(entry, sut) {
+        Testing_Assert(expected == entry->Key, "expected key %d but got %d", expected, entry->Key);
+        expected++;
+    }
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Remove_inside_ForEach_skips_nothing) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 50; i++) {
+        OrderedMap_Put(&sut, i, i);
+    }
+
+    int visited = 0;
+    OrderedMap_ForEach(entry, sut) {
+        Testing_Assert(visited == entry->Key, "expected key %d but got %d", visited, entry->Key);
+        if (entry->Key % 2 == 0) {
+            OrderedMap_Remove(&sut, entry->Key);
+        }
+        visited++;
+    }
+
+    Testing_Assert(50 == visited, "expected 50 entries to be visited but got %d", visited);
+    Testing_Assert(25 == sut.Size, "expected size to be 25 but was %zu", sut.Size);
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Default_functions_compare_string_keys_by_contents) {
+    StringIntOrderedMap sut = OrderedMap_Of(
+        StringIntOrderedMap, NULL, NULL,
+        {.Key = "one", .Value = 1},
+        {.Key = "two", .Value = 2},
+    );
+
+    char key[] = "two";
+    Testing_Assert(2 == OrderedMap_GetOrDefault(sut, key, -1), "expected keys to be compared by contents");
+    Testing_Assert(OrderedMap_Remove(&sut, key), "expected key to be removed");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+
+    OrderedMap_Free(&sut);
+}
+
+Testing_Fact(Random_operations_match_Map) {
+    IntIntOrderedMap sut = OrderedMap_Empty(IntIntOrderedMap, IntHashIdentity, IntEquals);
+    IntIntMap expected = Map_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    srand(42);
+
+    for (int i = 0; i < 20000; i++) {
+        int const key = rand() % 512;
+        if (rand() % 3 == 0) {
+            bool const removed = OrderedMap_Remove(&sut, key);
+            Testing_Assert(Map_Remove(&expected, key) == removed, "wrong result of removing key %d", key);
+        } else {
+            OrderedMap_Put(&sut, key, i);
+            Map_Put(&expected, key, i);
+        }
+    }
+
+    Testing_Assert(expected.Size == sut.Size, "expected size %zu but got %zu", expected.Size, sut.Size);
+    Map_ForEach(entry, expected) {
+        int const value = OrderedMap_GetOrDefault(sut, entry->Key, -1);
+        Testing_Assert(entry->Value == value, "expected value %d at key %d but got %d", entry->Value, entry->Key, value);
+    }
+    size_t visited = 0;
+    OrderedMap_ForEach(entry, sut) {
+        visited++;
+    }
+    Testing_Assert(sut.Size == visited, "expected %zu entries to be visited but got %zu", sut.Size, visited);
+
+    Map_Free(&expected);
+    OrderedMap_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Put_At_and_Remove_work_like_Map),
+        Testing_AddTest(ForEach_visits_entries_in_insertion_order),
+        Testing_AddTest(Put_of_existing_key_keeps_its_position),
+        Testing_AddTest(Remove_keeps_order_of_remaining_entries),
+        Testing_AddTest(Remove_keeps_colliding_keys_reachable),
+        Testing_AddTest(Put_reuses_space_of_removed_entries),
+        Testing_AddTest(Remove_inside_ForEach_skips_nothing),
+        Testing_AddTest(Default_functions_compare_string_keys_by_contents),
+        Testing_AddTest(Random_operations_match_Map),
+};
+
+Testing_RunAllTests();
@@ -0,0 +1,373 @@
+#ifndef RCU_MAP_H
+#define RCU_MAP_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__linux__) && __has_include(<linux/membarrier.h>)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#define RCU_MAP__HAS_MEMBARRIER 1
+#else
+#define RCU_MAP__HAS_MEMBARRIER 0
+#endif
+
+#include "map.h"
+
+// A map for data that is read very often from many threads and written
+// rarely. Readers take no locks and execute no atomic read-modify-write
+// instructions or memory fences: they look keys up in an immutable Map
+// snapshot exactly like Map_At does. Writers copy the current snapshot under a mutex, modify the
+// copy, publish it with a single pointer store, and free the previous
+// snapshot once no reader can still be using it.
+//
+// Every reading thread registers an RcuMapReader, which records the epoch
+// at which the thread entered its current read section, or 0 outside of
+// one. Publishing a snapshot advances the epoch and waits until every
+// registered reader is either idle or has entered after the new snapshot
+// became visible. Readers only write to their own RcuMapReader, which sits
+// on its own cache line, so they never contend with each other.
+//
+// The barrier between a reader's announcement and its load of the
+// snapshot is asymmetric: readers only keep the compiler from reordering
+// them, and the writer forces a full barrier on every thread of the
+// process with membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED). Where
+// membarrier is unavailable, readers fall back to a full fence.
+//
+// Writes cost O(Size), plus a wait for in-flight readers; prefer
+// RcuMap_Replace to publish many changes at once.
+
+#define RCU_MAP__CallChecked(Callee, ArgsList)  \
+({                                              \
+    int const _error = Callee ArgsList;         \
+    if (0 != _error) {                          \
+        fprintf(                                \
+            stderr, "[%s:%d] %s%s: %s\n",       \
+            __FILE_NAME__, __LINE__,            \
+            #Callee, #ArgsList,                 \
+            strerror(_error)                    \
+        );                                      \
+        exit(EXIT_FAILURE);                     \
+    }                                           \
+})
+
+#define RCU_MAP__Concat_(A, B)   A ## B
+#define RCU_MAP__Concat(A, B)    RCU_MAP__Concat_(A, B)
+
+#define RCU_MAP__CACHE_LINE_SIZE 64
+
+typedef struct RcuMapReader RcuMapReader;
+
+struct RcuMapReader {
+    alignas(RCU_MAP__CACHE_LINE_SIZE) _Atomic uint64_t Epoch;
+    RcuMapReader *Next;
+};
+
+typedef struct RcuMapDomain RcuMapDomain;
+
+struct RcuMapDomain {
+    pthread_mutex_t WriteLock;
+    _Atomic uint64_t Epoch;
+    RcuMapReader *Readers;
+    bool Expedited;
+};
+
+#define RcuMap(TKey, TValue)                \
+struct {                                    \
+    Map(TKey, TValue) *_Atomic Current;     \
+    RcuMapDomain Domain;                    \
+    Allocator Allocator;                    \
+}
+
+// Registering is needed once per process before the expedited command can
+// be used, and is cheap to repeat.
+static inline bool RCU_MAP__RegisterMembarrier(void) {
+#if RCU_MAP__HAS_MEMBARRIER
+    int const commands = (int) syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+    return commands >= 0
+        && 0 != (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED)
+        && 0 == syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0);
+#else
+    return false;
+#endif
+}
+
+static inline void RCU_MAP__InitDomain(RcuMapDomain *domain) {
+    RCU_MAP__CallChecked(pthread_mutex_init, (&domain->WriteLock, NULL));
+    atomic_init(&domain->Epoch, 1);
+    domain->Readers = NULL;
+    domain->Expedited = RCU_MAP__RegisterMembarrier();
+}
+
+static inline void RCU_MAP__Register(RcuMapDomain *domain, RcuMapReader *reader) {
+    atomic_init(&reader->Epoch, 0);
+    RCU_MAP__CallChecked(pthread_mutex_lock, (&domain->WriteLock));
+    reader->Next = domain->Readers;
+    domain->Readers = reader;
+    RCU_MAP__CallChecked(pthread_mutex_unlock, (&domain->WriteLock));
+}
+
+static inline void RCU_MAP__Unregister(RcuMapDomain *domain, RcuMapReader *reader) {
+    RCU_MAP__CallChecked(pthread_mutex_lock, (&domain->WriteLock));
+    RcuMapReader **link = &domain->Readers;
+    while (NULL != *link && reader != *link) {
+        link = &(*link)->Next;
+    }
+    if (NULL != *link) {
+        *link = reader->Next;
+    }
+    RCU_MAP__CallChecked(pthread_mutex_unlock, (&domain->WriteLock));
+}
+
+// Announce the current epoch before loading the snapshot. The fence orders
+// the announcement before the load of the snapshot pointer, and pairs
+// with the barrier in RCU_MAP__WaitForReaders: either the writer sees the
+// announcement and waits, or this reader sees the new snapshot. With
+// membarrier, the writer supplies the hardware barrier, so a compiler
+// fence is enough here.
+static inline RcuMapReader *RCU_MAP__Enter(RcuMapDomain *domain, RcuMapReader *reader) {
+    uint64_t const epoch = atomic_load_explicit(&domain->Epoch, memory_order_acquire);
+    atomic_store_explicit(&reader->Epoch, epoch, memory_order_relaxed);
+    if (domain->Expedited) {
+        atomic_signal_fence(memory_order_seq_cst);
+    } else {
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+    return reader;
+}
+
+// Takes a pointer to the reader pointer, so it can be used as a cleanup
+// function.
+static inline void RCU_MAP__Leave(RcuMapReader **reader) {
+    atomic_store_explicit(&(*reader)->Epoch, 0, memory_order_release);
+}
+
+// Must be called with WriteLock held, after the new snapshot has been
+// published. Returns once no reader can still see the previous one.
+static inline void RCU_MAP__WaitForReaders(RcuMapDomain *domain) {
+    uint64_t const epoch = atomic_fetch_add_explicit(&domain->Epoch, 1, memory_order_seq_cst) + 1;
+#if RCU_MAP__HAS_MEMBARRIER
+    if (domain->Expedited) {
+        if (0 != syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0)) {
+            fprintf(stderr, "[%s:%d] membarrier: %s\n", __FILE_NAME__, __LINE__, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+#endif
+    atomic_thread_fence(memory_order_seq_cst);
+    for (RcuMapReader *reader = domain->Readers; NULL != reader; reader = reader->Next) {
+        for (;;) {
+            uint64_t const seen = atomic_load_explicit(&reader->Epoch, memory_order_acquire);
+            if (0 == seen || seen >= epoch) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+#define RCU_MAP__NewSnapshot(MapPtr, Hash_, KeyEquals_)                                 \
+({                                                                                      \
+    __auto_type _map_ptr_snapshot = (MapPtr);                                           \
+    typeof(*_map_ptr_snapshot->Current) *_snapshot_new = MAP__CallChecked(              \
+        Allocator_Allocate, (                                                           \
+            _map_ptr_snapshot->Allocator,                                               \
+            sizeof(*_snapshot_new),                                                     \
+            alignof(typeof(*_snapshot_new))                                             \
+        ));                                                                             \
+    *_snapshot_new = Map_WithAllocator(                                                 \
+        typeof(*_snapshot_new), (Hash_), (KeyEquals_), _map_ptr_snapshot->Allocator);   \
+    _snapshot_new;                                                                      \
+})
+
+#define RCU_MAP__FreeSnapshot(MapPtr, Snapshot)                                         \
+do {                                                                                    \
+    __auto_type _snapshot_free = (Snapshot);                                            \
+    Map_Free(_snapshot_free);                                                           \
+    Allocator_Free((MapPtr)->Allocator, _snapshot_free, sizeof(*_snapshot_free));       \
+} while (0)
+
+// Return a copy of Snapshot with room for ExtraCount more entries. If it
+// fits, the table is copied as is, otherwise entries are inserted into a
+// larger one.
+#define RCU_MAP__Clone(MapPtr, Snapshot, ExtraCount)                                    \
+({                                                                                      \
+    __auto_type _old_clone = (Snapshot);                                                \
+    size_t const _count_clone = _old_clone->Size + (ExtraCount);                        \
+    __auto_type _new_clone = RCU_MAP__NewSnapshot(                                      \
+        (MapPtr), _old_clone->Hash, _old_clone->KeyEquals);                             \
+    if (MAP__NeedsToGrow(*_old_clone, _count_clone)) {                                  \
+        Map_Reserve(_new_clone, _count_clone);                                          \
+        Map_ForEach(_entry_clone, *_old_clone) {                                        \
+            Map_Put(_new_clone, _entry_clone->Key, _entry_clone->Value);                \
+        }                                                                               \
+    } else if (_old_clone->Capacity > 0) {                                              \
+        size_t const _size_clone =                                                      \
+            MAP__TableSize(sizeof(*_old_clone->Entries), _old_clone->Capacity);         \
+        _new_clone->Entries = MAP__AllocateTable(_new_clone, _old_clone->Capacity);     \
+        memcpy(_new_clone->Entries, _old_clone->Entries, _size_clone);                  \
+        _new_clone->Capacity = _old_clone->Capacity;                                    \
+        _new_clone->Size = _old_clone->Size;                                            \
+    }                                                                                   \
+    _new_clone;                                                                         \
+})
+
+// Must be called with WriteLock held.
+#define RCU_MAP__Publish(MapPtr, Snapshot)                                                  \
+do {                                                                                        \
+    __auto_type _map_ptr_publish = (MapPtr);                                                \
+    __auto_type _old_publish =                                                              \
+        atomic_load_explicit(&_map_ptr_publish->Current, memory_order_relaxed);             \
+    atomic_store_explicit(&_map_ptr_publish->Current, (Snapshot), memory_order_release);    \
+    RCU_MAP__WaitForReaders(&_map_ptr_publish->Domain);                                     \
+    RCU_MAP__FreeSnapshot(_map_ptr_publish, _old_publish);                                  \
+} while (0)
+
+#define RcuMap_InitWithAllocator(MapPtr, Hash_, KeyEquals_, Allocator_)                 \
+do {                                                                                    \
+    __auto_type _map_ptr_init = (MapPtr);                                               \
+    _map_ptr_init->Allocator = (Allocator_);                                            \
+    RCU_MAP__InitDomain(&_map_ptr_init->Domain);                                        \
+    atomic_init(                                                                        \
+        &_map_ptr_init->Current,                                                        \
+        RCU_MAP__NewSnapshot(_map_ptr_init, (Hash_), (KeyEquals_)));                    \
+} while (0)
+
+#define RcuMap_Init(MapPtr, Hash_, KeyEquals_) \
+    RcuMap_InitWithAllocator((MapPtr), (Hash_), (KeyEquals_), Allocator_Default())
+
+// Must not run concurrently with any other function on the same map.
+#define RcuMap_Free(MapPtr)                                                                         \
+do {                                                                                                \
+    __auto_type _map_ptr_free = (MapPtr);                                                           \
+    RCU_MAP__FreeSnapshot(                                                                          \
+        _map_ptr_free, atomic_load_explicit(&_map_ptr_free->Current, memory_order_relaxed));        \
+    atomic_store_explicit(&_map_ptr_free->Current, NULL, memory_order_relaxed);                     \
+    RCU_MAP__CallChecked(pthread_mutex_destroy, (&_map_ptr_free->Domain.WriteLock));                \
+} while (0)
+
+// ReaderPtr must stay valid until it is unregistered.
+#define RcuMap_Register(MapPtr, ReaderPtr) RCU_MAP__Register(&(MapPtr)->Domain, (ReaderPtr))
+
+#define RcuMap_Unregister(MapPtr, ReaderPtr) RCU_MAP__Unregister(&(MapPtr)->Domain, (ReaderPtr))
+
+// Return true if Key_ was not present before.
+#define RcuMap_Put(MapPtr, Key_, Value_)                                                \
+({                                                                                      \
+    __auto_type _map_ptr_put = (MapPtr);                                                \
+    RCU_MAP__CallChecked(pthread_mutex_lock, (&_map_ptr_put->Domain.WriteLock));        \
+    __auto_type _snapshot_put = RCU_MAP__Clone(                                         \
+        _map_ptr_put,                                                                   \
+        atomic_load_explicit(&_map_ptr_put->Current, memory_order_relaxed),             \
+        1);                                                                             \
+    bool _inserted_put;                                                                 \
+    MAP__Upsert(_snapshot_put, (Key_), &_inserted_put)->Value = (Value_);               \
+    RCU_MAP__Publish(_map_ptr_put, _snapshot_put);                                      \
+    RCU_MAP__CallChecked(pthread_mutex_unlock, (&_map_ptr_put->Domain.WriteLock));      \
+    _inserted_put;                                                                      \
+})
+
+#define RcuMap_Remove(MapPtr, Key_)                                                     \
+({                                                                                      \
+    __auto_type _map_ptr_remove = (MapPtr);                                             \
+    RCU_MAP__CallChecked(pthread_mutex_lock, (&_map_ptr_remove->Domain.WriteLock));     \
+    __auto_type _current_remove =                                                       \
+        atomic_load_explicit(&_map_ptr_remove->Current, memory_order_relaxed);          \
+    typeof(_current_remove->Entries->Key) _key_remove = (Key_);                         \
+    bool const _found_remove = NULL != MAP__Find(*_current_remove, _key_remove);        \
+    if (_found_remove) {                                                                \
+        __auto_type _snapshot_remove = RCU_MAP__Clone(                                  \
+            _map_ptr_remove, _current_remove, 0);                                       \
+        Map_Remove(_snapshot_remove, _key_remove);                                      \
+        RCU_MAP__Publish(_map_ptr_remove, _snapshot_remove);                            \
+    }                                                                                   \
+    RCU_MAP__CallChecked(pthread_mutex_unlock, (&_map_ptr_remove->Domain.WriteLock));   \
+    _found_remove;                                                                      \
+})
+
+// Publish all entries of Map_ at once, replacing the current ones. Map_
+// must be of type typeof(*MapPtr->Current) and use the same allocator,
+// and the map takes ownership of it.
+#define RcuMap_Replace(MapPtr, Map_)                                                    \
+do {                                                                                    \
+    __auto_type _map_ptr_replace = (MapPtr);                                            \
+    __auto_type _snapshot_replace = RCU_MAP__NewSnapshot(_map_ptr_replace, NULL, NULL); \
+    *_snapshot_replace = (Map_);                                                        \
+    MAP__Migrate(_snapshot_replace, SIZE_MAX);                                          \
+    RCU_MAP__CallChecked(pthread_mutex_lock, (&_map_ptr_replace->Domain.WriteLock));    \
+    RCU_MAP__Publish(_map_ptr_replace, _snapshot_replace);                              \
+    RCU_MAP__CallChecked(pthread_mutex_unlock, (&_map_ptr_replace->Domain.WriteLock));  \
+} while (0)
+
+#define RcuMap_TryGet(MapPtr, ReaderPtr, Key_, ValuePtr)                                \
+({                                                                                      \
+    __auto_type _map_ptr_try_get = (MapPtr);                                            \
+    typeof(_map_ptr_try_get->Current->Entries->Key) _key_try_get = (Key_);              \
+    RcuMapReader *_reader_try_get = RCU_MAP__Enter(                                     \
+        &_map_ptr_try_get->Domain, (ReaderPtr));                                        \
+    __auto_type _slot_try_get = MAP__Find(                                              \
+        *atomic_load_explicit(&_map_ptr_try_get->Current, memory_order_acquire),        \
+        _key_try_get);                                                                  \
+    if (NULL != _slot_try_get) {                                                        \
+        *(ValuePtr) = _slot_try_get->Value;                                             \
+    }                                                                                   \
+    RCU_MAP__Leave(&_reader_try_get);                                                   \
+    NULL != _slot_try_get;                                                              \
+})
+
+#define RcuMap_GetOrDefault(MapPtr, ReaderPtr, Key_, DefaultExpr)                       \
+({                                                                                      \
+    typeof((MapPtr)->Current->Entries->Value) _value_or_default;                        \
+    if (false == RcuMap_TryGet((MapPtr), (ReaderPtr), (Key_), &_value_or_default)) {    \
+        _value_or_default = (DefaultExpr);                                              \
+    }                                                                                   \
+    _value_or_default;                                                                  \
+})
+
+#define RCU_MAP__NextEntry(Snapshot, BaseIndex)                                         \
+({                                                                                      \
+    __auto_type _snapshot_next = (Snapshot);                                            \
+    size_t _index_next = 0;                                                             \
+    MAP__TryFindNextUsedIndex(*_snapshot_next, (BaseIndex), &_index_next)               \
+        ? &(_snapshot_next->Entries[_index_next])                                       \
+        : NULL;                                                                         \
+})
+
+// Iterate over one snapshot inside a read section, which ends when the
+// loop ends, also by break, return or goto. Writers wait for the loop to
+// end before freeing the snapshot, so keep the body short. The body must
+// not write to the map, nor read it with the same reader.
+#define RcuMap_ForEach(EntryPtr, MapPtr, ReaderPtr)                                                          \
+__auto_type RCU_MAP__Concat(_map_ptr_for_each_, __LINE__) = (MapPtr);                                        \
+for (                                                                                                        \
+    RcuMapReader *RCU_MAP__Concat(_reader_, __LINE__) __attribute__((cleanup(RCU_MAP__Leave))) =             \
+        RCU_MAP__Enter(&RCU_MAP__Concat(_map_ptr_for_each_, __LINE__)->Domain, (ReaderPtr)),                 \
+        *RCU_MAP__Concat(_once_, __LINE__) = RCU_MAP__Concat(_reader_, __LINE__);                            \
+    NULL != RCU_MAP__Concat(_once_, __LINE__);                                                               \
+    RCU_MAP__Concat(_once_, __LINE__) = NULL                                                                 \
+)                                                                                                            \
+for (                                                                                                        \
+    typeof(*RCU_MAP__Concat(_map_ptr_for_each_, __LINE__)->Current) *RCU_MAP__Concat(_snapshot_, __LINE__) = \
+        atomic_load_explicit(&RCU_MAP__Concat(_map_ptr_for_each_, __LINE__)->Current, memory_order_acquire); \
+    NULL != RCU_MAP__Concat(_snapshot_, __LINE__);                                                           \
+    RCU_MAP__Concat(_snapshot_, __LINE__) = NULL                                                             \
+)                                                                                                            \
+for (                                                                                                        \
+    typeof(RCU_MAP__Concat(_snapshot_, __LINE__)->Entries) EntryPtr =                                        \
+        RCU_MAP__NextEntry(RCU_MAP__Concat(_snapshot_, __LINE__), 0);                                        \
+    NULL != EntryPtr;                                                                                        \
+    EntryPtr = RCU_MAP__NextEntry(                                                                           \
+        RCU_MAP__Concat(_snapshot_, __LINE__),                                                               \
+        (size_t) (EntryPtr - RCU_MAP__Concat(_snapshot_, __LINE__)->Entries) + 1)                            \
+)
+
+#endif // RCU_MAP_H
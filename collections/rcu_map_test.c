@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "rcu_map.h"
+
+#include "testing/testing.h"
+
+#define READERS_COUNT   4
+#define KEYS_COUNT      500
+
+typedef RcuMap(int, int) IntIntMap;
+
+size_t IntHashIdentity(int value) {
+    return (size_t) value;
+}
+
+bool IntEquals(int a, int b) { return a == b; }
+
+typedef struct Reader Reader;
+struct Reader {
+    IntIntMap *Map;
+    atomic_bool *Done;
+    size_t Errors;
+};
+
+// Values are always twice their keys, so any other value means that a
+// reader saw a torn or freed snapshot.
+static void *Reader_Run(void *arg) {
+    Reader *reader = arg;
+    RcuMapReader slot;
+    RcuMap_Register(reader->Map, &slot);
+
+    int key = 0;
+    while (false == atomic_load(reader->Done)) {
+        int const value = RcuMap_GetOrDefault(reader->Map, &slot, key, -1);
+        reader->Errors += -1 != value && 2 * key != value;
+        key = (key + 1) % KEYS_COUNT;
+    }
+
+    RcuMap_Unregister(reader->Map, &slot);
+    return NULL;
+}
+
+typedef struct Writer Writer;
+struct Writer {
+    IntIntMap *Map;
+    atomic_bool Done;
+};
+
+static void *Writer_PutOne(void *arg) {
+    Writer *writer = arg;
+    RcuMap_Put(writer->Map, 1000, 2000);
+    atomic_store(&writer->Done, true);
+    return NULL;
+}
+
+Testing_Fact(Put_TryGet_and_Remove_work_like_Map) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+    RcuMapReader reader;
+    RcuMap_Register(&sut, &reader);
+
+    Testing_Assert(-1 == RcuMap_GetOrDefault(&sut, &reader, 1, -1), "expected empty map to have no keys");
+    Testing_Assert(true == RcuMap_Put(&sut, 1, 10), "expected Put to report inserted key");
+    Testing_Assert(false == RcuMap_Put(&sut, 1, 11), "expected Put to report existing key");
+    RcuMap_Put(&sut, 2, 20);
+
+    int value = 0;
+    Testing_Assert(RcuMap_TryGet(&sut, &reader, 1, &value), "expected key 1 to be found");
+    Testing_Assert(11 == value, "expected value 11 but got %d", value);
+    Testing_Assert(20 == RcuMap_GetOrDefault(&sut, &reader, 2, -1), "expected value 20 at key 2");
+
+    Testing_Assert(true == RcuMap_Remove(&sut, 1), "expected existing key to be removed");
+    Testing_Assert(false == RcuMap_Remove(&sut, 1), "expected removed key to not be found");
+    Testing_Assert(false == RcuMap_TryGet(&sut, &reader, 1, &value), "expected removed key to be gone");
+    Testing_Assert(1 == sut.Current->Size, "expected size to be 1 but was %zu", sut.Current->Size);
+
+    RcuMap_Unregister(&sut, &reader);
+    RcuMap_Free(&sut);
+}
+
+Testing_Fact(Put_grows_map_and_keeps_all_entries) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+    RcuMapReader reader;
+    RcuMap_Register(&sut, &reader);
+
+    for (int i = 0; i < KEYS_COUNT; i++) {
+        RcuMap_Put(&sut, i, 2 * i);
+    }
+
+    Testing_Assert(KEYS_COUNT == (int) sut.Current->Size, "expected size to be %d", KEYS_COUNT);
+    for (int i = 0; i < KEYS_COUNT; i++) {
+        Testing_Assert(2 * i == RcuMap_GetOrDefault(&sut, &reader, i, -1), "wrong value at key %d", i);
+    }
+
+    RcuMap_Unregister(&sut, &reader);
+    RcuMap_Free(&sut);
+}
+
+Testing_Fact(Replace_publishes_all_entries_at_once) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+    RcuMapReader reader;
+    RcuMap_Register(&sut, &reader);
+    RcuMap_Put(&sut, -1, -1);
+
+    typeof(*sut.Current) next = Map_Empty(typeof(*sut.Current), IntHashIdentity, IntEquals);
+    for (int i = 0; i < 100; i++) {
+        Map_Put(&next, i, 2 * i);
+    }
+    RcuMap_Replace(&sut, next);
+
+    Testing_Assert(0 == RcuMap_GetOrDefault(&sut, &reader, -1, 0), "expected old entries to be replaced");
+    Testing_Assert(100 == sut.Current->Size, "expected size to be 100 but was %zu", sut.Current->Size);
+    Testing_Assert(198 == RcuMap_GetOrDefault(&sut, &reader, 99, -1), "expected new entries to be found");
+
+    RcuMap_Unregister(&sut, &reader);
+    RcuMap_Free(&sut);
+}
+
+Testing_Fact(ForEach_visits_every_entry_once) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+    RcuMapReader reader;
+    RcuMap_Register(&sut, &reader);
+
+    RcuMap_ForEach(entry, &sut, &reader) {
+        Testing_Assert(false, "expected body to never be executed for empty map");
+    }
+
+    for (int i = 0; i < KEYS_COUNT; i++) {
+        RcuMap_Put(&sut, i, -i);
+    }
+
+    bool visited[KEYS_COUNT] = {0};
+    int visitedCount = 0;
+    RcuMap_ForEach(entry, &sut, &reader) {
+        Testing_Assert(entry->Key >= 0 && entry->Key < KEYS_COUNT, "unexpected key %d", entry->Key);
+        Testing_Assert(false == visited[entry->Key], "expected key %d to be visited once", entry->Key);
+        visited[entry->Key] = true;
+        visitedCount++;
+    }
+    Testing_Assert(KEYS_COUNT == visitedCount, "expected %d entries to be visited but got %d", KEYS_COUNT, visitedCount);
+
+    RcuMap_Unregister(&sut, &reader);
+    RcuMap_Free(&sut);
+}
+
+Testing_Fact(Writer_waits_until_readers_leave_their_read_section) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+    RcuMapReader reader;
+    RcuMap_Register(&sut, &reader);
+    RcuMap_Put(&sut, 1, 2);
+
+    Writer writer = {.Map = &sut};
+    atomic_init(&writer.Done, false);
+    pthread_t thread;
+    RcuMap_ForEach(entry, &sut, &reader) {
+        pthread_create(&thread, NULL, Writer_PutOne, &writer);
+        usleep(50 * 1000);
+        Testing_Assert(false == atomic_load(&writer.Done), "expected writer to wait for the reader");
+        Testing_Assert(1 == entry->Key && 2 == entry->Value, "expected snapshot to stay intact");
+        break;
+    }
+    pthread_join(thread, NULL);
+
+    Testing_Assert(true == atomic_load(&writer.Done), "expected writer to finish after the reader left");
+    Testing_Assert(2000 == RcuMap_GetOrDefault(&sut, &reader, 1000, -1), "expected new key to be published");
+
+    RcuMap_Unregister(&sut, &reader);
+    RcuMap_Free(&sut);
+}
+
+Testing_Fact(Readers_see_consistent_values_while_writer_updates_map) {
+    IntIntMap sut;
+    RcuMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    atomic_bool done;
+    atomic_init(&done, false);
+    static Reader readers[READERS_COUNT];
+    pthread_t threads[READERS_COUNT];
+    for (size_t i = 0; i < READERS_COUNT; i++) {
+        readers[i] = (Reader) {.Map = &sut, .Done = &done};
+        pthread_create(&threads[i], NULL, Reader_Run, &readers[i]);
+    }
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < KEYS_COUNT; i++) {
+            RcuMap_Put(&sut, i, 2 * i);
+        }
+        for (int i = round; i < KEYS_COUNT; i += 3) {
+            RcuMap_Remove(&sut, i);
+        }
+    }
+    atomic_store(&done, true);
+
+    for (size_t i = 0; i < READERS_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+        Testing_Assert(0 == readers[i].Errors, "expected reader %zu to see consistent values", i);
+    }
+
+    RcuMap_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Put_TryGet_and_Remove_work_like_Map),
+        Testing_AddTest(Put_grows_map_and_keeps_all_entries),
+        Testing_AddTest(Replace_publishes_all_entries_at_once),
+        Testing_AddTest(ForEach_visits_every_entry_once),
+        Testing_AddTest(Writer_waits_until_readers_leave_their_read_section),
+        Testing_AddTest(Readers_see_consistent_values_while_writer_updates_map),
+};
+
+Testing_RunAllTests();
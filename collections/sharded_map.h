@@ -0,0 +1,249 @@
+#ifndef SHARDED_MAP_H
+#define SHARDED_MAP_H
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <pthread.h>
+
+#include "map.h"
+
+// A map that can be used from several threads at once. Keys are spread
+// over SHARDED_MAP_SHARD_COUNT shards by the high bits of their mixed
+// hash, and every shard is a Map guarded by its own reader-writer lock,
+// so operations on different shards never wait for each other. The low
+// bits of the same hash still select the slot within a shard, so each
+// key is hashed only once.
+//
+// Unlike Map, the functions take a pointer to the map and never return
+// pointers into it: another thread may move or remove the entry as soon
+// as the lock is released. Values are copied out instead. A custom
+// allocator must be safe to use from several threads.
+
+#define SHARDED_MAP__CallChecked(Callee, ArgsList)  \
+({                                                  \
+    int const _error = Callee ArgsList;             \
+    if (0 != _error) {                              \
+        fprintf(                                    \
+            stderr, "[%s:%d] %s%s: %s\n",           \
+            __FILE_NAME__, __LINE__,                \
+            #Callee, #ArgsList,                     \
+            strerror(_error)                        \
+        );                                          \
+        exit(EXIT_FAILURE);                         \
+    }                                               \
+})
+
+#define SHARDED_MAP__Concat_(A, B)   A ## B
+#define SHARDED_MAP__Concat(A, B)    SHARDED_MAP__Concat_(A, B)
+
+#ifndef SHARDED_MAP_SHARD_BITS
+#define SHARDED_MAP_SHARD_BITS 5
+#endif
+
+#define SHARDED_MAP_SHARD_COUNT ((size_t) 1 << SHARDED_MAP_SHARD_BITS)
+
+// Shards are aligned to separate cache lines, so that taking the lock of
+// one shard does not invalidate the line holding its neighbour.
+#define SHARDED_MAP__CACHE_LINE_SIZE 64
+
+#define ShardedMap(TKey, TValue)                                     \
+struct {                                                             \
+    struct {                                                         \
+        alignas(SHARDED_MAP__CACHE_LINE_SIZE) pthread_rwlock_t Lock; \
+        Map(TKey, TValue) Map;                                       \
+    } Shards[SHARDED_MAP_SHARD_COUNT];                               \
+}
+
+#define SHARDED_MAP__HashOf(MapPtr, Key_) MAP__HashOf((MapPtr)->Shards[0].Map, (Key_))
+
+#define SHARDED_MAP__ShardOf(MapPtr, Hash_) \
+    (&((MapPtr)->Shards[(Hash_) >> (sizeof(size_t) * CHAR_BIT - SHARDED_MAP_SHARD_BITS)]))
+
+// Locks cannot be copied, so a sharded map is initialized in place
+// rather than returned by value like Map_Empty.
+#define ShardedMap_InitWithAllocator(MapPtr, Hash_, KeyEquals_, Allocator_)                          \
+do {                                                                                                 \
+    __auto_type _map_ptr_init = (MapPtr);                                                            \
+    typeof(_map_ptr_init->Shards[0].Map) const _empty_init = Map_WithAllocator(                      \
+        typeof(_map_ptr_init->Shards[0].Map), (Hash_), (KeyEquals_), (Allocator_));                  \
+    for (size_t _i_init = 0; _i_init < SHARDED_MAP_SHARD_COUNT; _i_init++) {                         \
+        SHARDED_MAP__CallChecked(pthread_rwlock_init, (&_map_ptr_init->Shards[_i_init].Lock, NULL)); \
+        _map_ptr_init->Shards[_i_init].Map = _empty_init;                                            \
+    }                                                                                                \
+} while (0)
+
+#define ShardedMap_Init(MapPtr, Hash_, KeyEquals_) \
+    ShardedMap_InitWithAllocator((MapPtr), (Hash_), (KeyEquals_), Allocator_Default())
+
+// Must not run concurrently with any other function on the same map.
+#define ShardedMap_Free(MapPtr)                                                                   \
+do {                                                                                              \
+    __auto_type _map_ptr_free = (MapPtr);                                                         \
+    for (size_t _i_free = 0; _i_free < SHARDED_MAP_SHARD_COUNT; _i_free++) {                      \
+        Map_Free(&_map_ptr_free->Shards[_i_free].Map);                                            \
+        SHARDED_MAP__CallChecked(pthread_rwlock_destroy, (&_map_ptr_free->Shards[_i_free].Lock)); \
+    }                                                                                             \
+} while (0)
+
+#define SHARDED_MAP__Upsert(MapPtr, Key_, Value_, Overwrite)                          \
+({                                                                                    \
+    __auto_type _map_ptr_upsert = (MapPtr);                                           \
+    typeof(_map_ptr_upsert->Shards[0].Map.Entries->Key) _key_sharded = (Key_);        \
+    size_t const _hash_sharded = SHARDED_MAP__HashOf(_map_ptr_upsert, _key_sharded);  \
+    __auto_type _shard_upsert = SHARDED_MAP__ShardOf(_map_ptr_upsert, _hash_sharded); \
+    bool _inserted_sharded;                                                           \
+    SHARDED_MAP__CallChecked(pthread_rwlock_wrlock, (&_shard_upsert->Lock));          \
+    __auto_type _slot_sharded = MAP__UpsertWithHash(                                  \
+        &_shard_upsert->Map, _key_sharded, _hash_sharded, &_inserted_sharded);        \
+    if ((Overwrite) || _inserted_sharded) {                                           \
+        _slot_sharded->Value = (Value_);                                              \
+    }                                                                                 \
+    SHARDED_MAP__CallChecked(pthread_rwlock_unlock, (&_shard_upsert->Lock));          \
+    _inserted_sharded;                                                                \
+})
+
+// Return true if Key_ was not present before. Value_ is evaluated before
+// the shard is locked, so it may read the same map.
+#define ShardedMap_Put(MapPtr, Key_, Value_)                                  \
+({                                                                            \
+    __auto_type _map_ptr_put = (MapPtr);                                      \
+    typeof(_map_ptr_put->Shards[0].Map.Entries->Key) _key_put = (Key_);       \
+    typeof(_map_ptr_put->Shards[0].Map.Entries->Value) _value_put = (Value_); \
+    SHARDED_MAP__Upsert(_map_ptr_put, _key_put, _value_put, true);            \
+})
+
+// Like Map_TryPut, Value_ is evaluated only if Key_ is inserted. It runs
+// while the shard's write lock is held, so it must not use the same map.
+#define ShardedMap_TryPut(MapPtr, Key_, Value_) SHARDED_MAP__Upsert((MapPtr), (Key_), (Value_), false)
+
+#define ShardedMap_TryGet(MapPtr, Key_, ValuePtr)                                       \
+({                                                                                      \
+    __auto_type _map_ptr_try_get = (MapPtr);                                            \
+    typeof(_map_ptr_try_get->Shards[0].Map.Entries->Key) _key_try_get = (Key_);         \
+    size_t const _hash_try_get = SHARDED_MAP__HashOf(_map_ptr_try_get, _key_try_get);   \
+    __auto_type _shard_try_get = SHARDED_MAP__ShardOf(_map_ptr_try_get, _hash_try_get); \
+    SHARDED_MAP__CallChecked(pthread_rwlock_rdlock, (&_shard_try_get->Lock));           \
+    __auto_type _slot_try_get = MAP__FindWithHash(                                      \
+        _shard_try_get->Map, _key_try_get, _hash_try_get);                              \
+    if (NULL != _slot_try_get) {                                                        \
+        *(ValuePtr) = _slot_try_get->Value;                                             \
+    }                                                                                   \
+    SHARDED_MAP__CallChecked(pthread_rwlock_unlock, (&_shard_try_get->Lock));           \
+    NULL != _slot_try_get;                                                              \
+})
+
+// DefaultExpr is evaluated without holding any lock.
+#define ShardedMap_GetOrDefault(MapPtr, Key_, DefaultExpr)                          \
+({                                                                                  \
+    typeof((MapPtr)->Shards[0].Map.Entries->Value) _value_or_default;               \
+    if (false == ShardedMap_TryGet((MapPtr), (Key_), &_value_or_default)) {         \
+        _value_or_default = (DefaultExpr);                                          \
+    }                                                                               \
+    _value_or_default;                                                              \
+})
+
+#define ShardedMap_Remove(MapPtr, Key_)                                              \
+({                                                                                   \
+    __auto_type _map_ptr_remove = (MapPtr);                                          \
+    typeof(_map_ptr_remove->Shards[0].Map.Entries->Key) _key_remove = (Key_);        \
+    size_t const _hash_remove = SHARDED_MAP__HashOf(_map_ptr_remove, _key_remove);   \
+    __auto_type _shard_remove = SHARDED_MAP__ShardOf(_map_ptr_remove, _hash_remove); \
+    SHARDED_MAP__CallChecked(pthread_rwlock_wrlock, (&_shard_remove->Lock));         \
+    MAP__Migrate(&_shard_remove->Map, _shard_remove->Map.RehashStep);                \
+    __auto_type _slot_remove = MAP__FindWithHash(                                    \
+        _shard_remove->Map, _key_remove, _hash_remove);                              \
+    if (NULL != _slot_remove) {                                                      \
+        MAP__Erase(&_shard_remove->Map, _slot_remove);                               \
+    }                                                                                \
+    SHARDED_MAP__CallChecked(pthread_rwlock_unlock, (&_shard_remove->Lock));         \
+    NULL != _slot_remove;                                                            \
+})
+
+// Number of entries, counted one shard at a time. Concurrent writers may
+// change it before it is returned.
+#define ShardedMap_Size(MapPtr)                                                                  \
+({                                                                                               \
+    __auto_type _map_ptr_size = (MapPtr);                                                        \
+    size_t _size_sharded = 0;                                                                    \
+    for (size_t _i_size = 0; _i_size < SHARDED_MAP_SHARD_COUNT; _i_size++) {                     \
+        SHARDED_MAP__CallChecked(pthread_rwlock_rdlock, (&_map_ptr_size->Shards[_i_size].Lock)); \
+        _size_sharded += _map_ptr_size->Shards[_i_size].Map.Size;                                \
+        SHARDED_MAP__CallChecked(pthread_rwlock_unlock, (&_map_ptr_size->Shards[_i_size].Lock)); \
+    }                                                                                            \
+    _size_sharded;                                                                               \
+})
+
+// Position of ShardedMap_ForEach. Locked is the lock of the current
+// shard while it is being iterated, and is released when the loop ends,
+// including by break, return or goto.
+typedef struct ShardedMapCursor ShardedMapCursor;
+
+struct ShardedMapCursor {
+    pthread_rwlock_t *Locked;
+    size_t Shard;
+    size_t Index;
+};
+
+static inline void SHARDED_MAP__Release(ShardedMapCursor *cursor) {
+    if (NULL != cursor->Locked) {
+        SHARDED_MAP__CallChecked(pthread_rwlock_unlock, (cursor->Locked));
+        cursor->Locked = NULL;
+    }
+}
+
+#define SHARDED_MAP__Next(MapPtr, CursorPtr)                                        \
+({                                                                                  \
+    __auto_type _map_ptr_next = (MapPtr);                                           \
+    ShardedMapCursor *_cursor_next = (CursorPtr);                                   \
+    typeof(_map_ptr_next->Shards[0].Map.Entries) _entry_next = NULL;                \
+    while (NULL == _entry_next && _cursor_next->Shard < SHARDED_MAP_SHARD_COUNT) {  \
+        __auto_type _shard_next = &(_map_ptr_next->Shards[_cursor_next->Shard]);    \
+        if (NULL == _cursor_next->Locked) {                                         \
+            SHARDED_MAP__CallChecked(pthread_rwlock_rdlock, (&_shard_next->Lock));  \
+            _cursor_next->Locked = &_shard_next->Lock;                              \
+        }                                                                           \
+        if (MAP__TryFindNextUsedIndex(                                              \
+                _shard_next->Map, _cursor_next->Index, &_cursor_next->Index)) {     \
+            _entry_next = MAP__EntryAt(_shard_next->Map, _cursor_next->Index);      \
+            _cursor_next->Index += 1;                                               \
+        } else {                                                                    \
+            SHARDED_MAP__Release(_cursor_next);                                     \
+            _cursor_next->Shard += 1;                                               \
+            _cursor_next->Index = 0;                                                \
+        }                                                                           \
+    }                                                                               \
+    _entry_next;                                                                    \
+})
+
+// Iterate shard by shard, holding the read lock of the current shard, so
+// entries of other shards may change meanwhile. The body must not modify
+// the map.
+#define ShardedMap_ForEach(EntryPtr, MapPtr)                                                        \
+__auto_type SHARDED_MAP__Concat(_map_ptr_for_each_, __LINE__) = (MapPtr);                           \
+for (                                                                                               \
+    ShardedMapCursor SHARDED_MAP__Concat(_cursor_, __LINE__)                                        \
+        __attribute__((cleanup(SHARDED_MAP__Release))) = {0},                                       \
+        *SHARDED_MAP__Concat(_once_, __LINE__) = &SHARDED_MAP__Concat(_cursor_, __LINE__);          \
+    NULL != SHARDED_MAP__Concat(_once_, __LINE__);                                                  \
+    SHARDED_MAP__Concat(_once_, __LINE__) = NULL                                                    \
+)                                                                                                   \
+for (                                                                                               \
+    typeof(SHARDED_MAP__Concat(_map_ptr_for_each_, __LINE__)->Shards[0].Map.Entries) EntryPtr =     \
+        SHARDED_MAP__Next(                                                                          \
+            SHARDED_MAP__Concat(_map_ptr_for_each_, __LINE__),                                      \
+            &SHARDED_MAP__Concat(_cursor_, __LINE__)                                                \
+        );                                                                                          \
+    NULL != EntryPtr;                                                                               \
+    EntryPtr =                                                                                      \
+        SHARDED_MAP__Next(                                                                          \
+            SHARDED_MAP__Concat(_map_ptr_for_each_, __LINE__),                                      \
+            &SHARDED_MAP__Concat(_cursor_, __LINE__)                                                \
+        )                                                                                           \
+)
+
+#endif // SHARDED_MAP_H
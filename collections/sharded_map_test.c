@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "sharded_map.h"
+
+#include "testing/testing.h"
+
+#define THREADS_COUNT       8
+#define KEYS_PER_THREAD     20000
+
+typedef ShardedMap(int, int) IntIntMap;
+typedef ShardedMap(char const *, int) StringIntMap;
+
+size_t IntHashIdentity(int value) {
+    return (size_t) value;
+}
+
+bool IntEquals(int a, int b) { return a == b; }
+
+typedef struct Worker Worker;
+struct Worker {
+    IntIntMap *Map;
+    int Id;
+    size_t Errors;
+};
+
+static void *Worker_PutOwnKeys(void *arg) {
+    Worker *worker = arg;
+
+    for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        int const key = i * THREADS_COUNT + worker->Id;
+        worker->Errors += false == ShardedMap_Put(worker->Map, key, 2 * key);
+    }
+
+    return NULL;
+}
+
+// Every thread inserts, reads and removes its own keys, and reads keys of
+// the other threads, which must either be missing or have the right value.
+static void *Worker_Churn(void *arg) {
+    Worker *worker = arg;
+    unsigned state = (unsigned) worker->Id + 1;
+
+    for (int step = 0; step < KEYS_PER_THREAD; step++) {
+        state = state * 1103515245 + 12345;
+        int const own = (int) ((state >> 8) % 1000) * THREADS_COUNT + worker->Id;
+        switch (state >> 29) {
+            case 0:
+                ShardedMap_Remove(worker->Map, own);
+                worker->Errors += -1 != ShardedMap_GetOrDefault(worker->Map, own, -1);
+                break;
+            case 1:
+            case 2:
+            case 3:
+                ShardedMap_Put(worker->Map, own, 2 * own);
+                worker->Errors += 2 * own != ShardedMap_GetOrDefault(worker->Map, own, -1);
+                break;
+            default: {
+                int const other = (int) ((state >> 8) % (1000 * THREADS_COUNT));
+                int const value = ShardedMap_GetOrDefault(worker->Map, other, -1);
+                worker->Errors += -1 != value && 2 * other != value;
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void RunWorkers(IntIntMap *map, void *(*run)(void *), Worker workers[static THREADS_COUNT]) {
+    pthread_t threads[THREADS_COUNT];
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        workers[i] = (Worker) {.Map = map, .Id = i};
+        pthread_create(&threads[i], NULL, run, &workers[i]);
+    }
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+Testing_Fact(Put_TryGet_and_Remove_work_like_Map) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    Testing_Assert(0 == ShardedMap_Size(&sut), "expected new map to be empty");
+    Testing_Assert(true == ShardedMap_Put(&sut, 1, 10), "expected Put to report inserted key");
+    Testing_Assert(false == ShardedMap_Put(&sut, 1, 11), "expected Put to report existing key");
+    Testing_Assert(false == ShardedMap_TryPut(&sut, 1, 12), "expected TryPut to keep existing key");
+    Testing_Assert(true == ShardedMap_TryPut(&sut, 2, 20), "expected TryPut to insert missing key");
+
+    int value = 0;
+    Testing_Assert(ShardedMap_TryGet(&sut, 1, &value), "expected key 1 to be found");
+    Testing_Assert(11 == value, "expected value 11 but got %d", value);
+    Testing_Assert(20 == ShardedMap_GetOrDefault(&sut, 2, -1), "expected value 20 at key 2");
+    Testing_Assert(-1 == ShardedMap_GetOrDefault(&sut, 3, -1), "expected missing key to not be found");
+    Testing_Assert(2 == ShardedMap_Size(&sut), "expected size to be 2");
+
+    Testing_Assert(true == ShardedMap_Remove(&sut, 1), "expected existing key to be removed");
+    Testing_Assert(false == ShardedMap_Remove(&sut, 1), "expected removed key to not be found");
+    Testing_Assert(1 == ShardedMap_Size(&sut), "expected size to be 1");
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(Put_value_may_read_the_same_map) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 5; i++) {
+        ShardedMap_Put(&sut, 1, ShardedMap_GetOrDefault(&sut, 1, 0) + 1);
+    }
+
+    Testing_Assert(5 == ShardedMap_GetOrDefault(&sut, 1, -1), "expected counter to be incremented 5 times");
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(Init_uses_default_functions_when_given_NULL) {
+    StringIntMap sut;
+    ShardedMap_Init(&sut, NULL, NULL);
+
+    char key[] = "two";
+    ShardedMap_Put(&sut, "one", 1);
+    ShardedMap_Put(&sut, "two", 2);
+
+    Testing_Assert(2 == ShardedMap_GetOrDefault(&sut, key, -1), "expected keys to be compared by contents");
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(Keys_are_spread_over_all_shards) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 1000; i++) {
+        ShardedMap_Put(&sut, i, i);
+    }
+
+    for (size_t shard = 0; shard < SHARDED_MAP_SHARD_COUNT; shard++) {
+        size_t const size = sut.Shards[shard].Map.Size;
+        Testing_Assert(size > 0 && size < 100, "expected shard %zu to hold a fair share but got %zu", shard, size);
+    }
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(Put_from_many_threads_keeps_all_keys) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    static Worker workers[THREADS_COUNT];
+    RunWorkers(&sut, Worker_PutOwnKeys, workers);
+
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        Testing_Assert(0 == workers[i].Errors, "expected every key of thread %d to be new", i);
+    }
+    size_t const expectedSize = THREADS_COUNT * KEYS_PER_THREAD;
+    Testing_Assert(expectedSize == ShardedMap_Size(&sut), "expected size to be %zu", expectedSize);
+    for (int key = 0; key < THREADS_COUNT * KEYS_PER_THREAD; key++) {
+        Testing_Assert(2 * key == ShardedMap_GetOrDefault(&sut, key, -1), "wrong value at key %d", key);
+    }
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(Mixed_reads_and_writes_from_many_threads_keep_map_consistent) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    static Worker workers[THREADS_COUNT];
+    RunWorkers(&sut, Worker_Churn, workers);
+
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        Testing_Assert(0 == workers[i].Errors, "expected thread %d to see consistent values", i);
+    }
+    size_t visited = 0;
+    ShardedMap_ForEach(entry, &sut) {
+        Testing_Assert(2 * entry->Key == entry->Value, "wrong value at key %d", entry->Key);
+        visited++;
+    }
+    Testing_Assert(ShardedMap_Size(&sut) == visited, "expected ForEach to visit every entry");
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(ForEach_visits_every_entry_once) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+
+    ShardedMap_ForEach(entry, &sut) {
+        Testing_Assert(false, "expected body to never be executed for empty map");
+    }
+
+    int const keysCount = 300;
+    for (int i = 0; i < keysCount; i++) {
+        ShardedMap_Put(&sut, i, -i);
+    }
+
+    bool visited[keysCount];
+    memset(visited, 0x00, sizeof(visited));
+    int visitedCount = 0;
+    ShardedMap_ForEach(entry, &sut) {
+        Testing_Assert(entry->Key >= 0 && entry->Key < keysCount, "unexpected key %d", entry->Key);
+        Testing_Assert(false == visited[entry->Key], "expected key %d to be visited once", entry->Key);
+        visited[entry->Key] = true;
+        visitedCount++;
+    }
+    Testing_Assert(keysCount == visitedCount, "expected %d entries to be visited but got %d", keysCount, visitedCount);
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_Fact(ForEach_releases_lock_when_loop_is_left_early) {
+    IntIntMap sut;
+    ShardedMap_Init(&sut, IntHashIdentity, IntEquals);
+    for (int i = 0; i < 100; i++) {
+        ShardedMap_Put(&sut, i, i);
+    }
+
+    ShardedMap_ForEach(entry, &sut) {
+        (void) entry;
+        break;
+    }
+
+    for (size_t shard = 0; shard < SHARDED_MAP_SHARD_COUNT; shard++) {
+        bool const unlocked = 0 == pthread_rwlock_trywrlock(&sut.Shards[shard].Lock);
+        Testing_Assert(unlocked, "expected shard %zu to be unlocked", shard);
+        if (unlocked) {
+            pthread_rwlock_unlock(&sut.Shards[shard].Lock);
+        }
+    }
+
+    ShardedMap_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Put_TryGet_and_Remove_work_like_Map),
+        Testing_AddTest(Put_value_may_read_the_same_map),
+        Testing_AddTest(Init_uses_default_functions_when_given_NULL),
+        Testing_AddTest(Keys_are_spread_over_all_shards),
+        Testing_AddTest(Put_from_many_threads_keeps_all_keys),
+        Testing_AddTest(Mixed_reads_and_writes_from_many_threads_keep_map_consistent),
+        Testing_AddTest(ForEach_visits_every_entry_once),
+        Testing_AddTest(ForEach_releases_lock_when_loop_is_left_early),
+};
+
+Testing_RunAllTests();
@@ -0,0 +1,468 @@
+#ifndef SWISS_MAP_H
+#define SWISS_MAP_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
+#include "hash.h"
+#include "map.h"
+
+// Define SWISS_MAP_NO_SIMD to use the portable group matching even when
+// SSE2 is available.
+#if defined(__SSE2__) && !defined(SWISS_MAP_NO_SIMD)
+#define SWISS_MAP__SSE2
+#include <emmintrin.h>
+#endif
+
+#define SWISS_MAP__CallChecked(Callee, ArgsList)    \
+({                                                  \
+    errno = 0;                                      \
+    __auto_type _r = Callee ArgsList;               \
+    if (errno) {                                    \
+        fprintf(                                    \
+            stderr, "[%s:%d] %s%s: %s\n",           \
+            __FILE_NAME__, __LINE__,                \
+            #Callee, #ArgsList,                     \
+            strerror(errno)                         \
+        );                                          \
+        exit(EXIT_FAILURE);                         \
+    }                                               \
+    _r;                                             \
+})
+
+#define SWISS_MAP__Concat_(A, B)   A ## B
+#define SWISS_MAP__Concat(A, B)    SWISS_MAP__Concat_(A, B)
+
+// Slots are probed in aligned groups of SWISS_MAP_GROUP_WIDTH, so
+// capacity is always zero or a power of two not less than that.
+#define SWISS_MAP_GROUP_WIDTH 16
+
+// A control byte is either one of the two negative markers below, or
+// the 7 low bits of the hash of the key stored in the slot.
+#define SWISS_MAP__EMPTY    ((int8_t) -128)
+#define SWISS_MAP__DELETED  ((int8_t) -2)
+
+#define SwissMap(TKey, TValue)      \
+struct {                            \
+    size_t Size;                    \
+    size_t Capacity;                \
+    size_t GrowthLeft;              \
+    size_t (*Hash)(TKey);           \
+    bool (*KeyEquals)(TKey, TKey);  \
+    int8_t *Control;                \
+    struct {                        \
+        TKey Key;                   \
+        TValue Value;               \
+    } *Entries;                     \
+    Allocator Allocator;            \
+}
+
+// As with Map_Empty, Hash_ and KeyEquals_ may be NULL for integer and C
+// string keys, which selects inlinable defaults by key type.
+#define SwissMap_Empty(MapType, Hash_, KeyEquals_) ((MapType) {.Hash = (Hash_), .KeyEquals = (KeyEquals_)})
+
+#define SwissMap_WithAllocator(MapType, Hash_, KeyEquals_, Allocator_)  \
+((MapType) {                                                            \
+    .Hash = (Hash_),                                                    \
+    .KeyEquals = (KeyEquals_),                                          \
+    .Allocator = (Allocator_),                                          \
+})
+
+// The user hash is mixed before being split into the group index (H1)
+// and the 7-bit control tag (H2), which both need well-distributed bits.
+#define SWISS_MAP__Mix(Hash) Hash_UInt64(Hash)
+
+#define SWISS_MAP__H1(Hash) ((Hash) >> 7)
+#define SWISS_MAP__H2(Hash) ((int8_t) ((Hash) & 0x7F))
+
+// Return a bit mask with bit i set iff Group[i] == Byte.
+static inline uint32_t SWISS_MAP__MatchByte(int8_t const *group, int8_t byte) {
+#ifdef SWISS_MAP__SSE2
+    __m128i const control = _mm_load_si128((__m128i const *) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(byte)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < SWISS_MAP_GROUP_WIDTH; i++) {
+        mask |= (uint32_t) (group[i] == byte) << i;
+    }
+    return mask;
+#endif
+}
+
+// Return a bit mask with bit i set iff Group[i] is empty or deleted.
+static inline uint32_t SWISS_MAP__MatchFree(int8_t const *group) {
+#ifdef SWISS_MAP__SSE2
+    return (uint32_t) _mm_movemask_epi8(_mm_load_si128((__m128i const *) group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < SWISS_MAP_GROUP_WIDTH; i++) {
+        mask |= (uint32_t) (group[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+#define SWISS_MAP__MatchEmpty(Group) SWISS_MAP__MatchByte((Group), SWISS_MAP__EMPTY)
+
+// Control bytes and entries share a single allocation.
+#define SWISS_MAP__EntriesOffset(MapType, Capacity)                                 \
+(((Capacity) + alignof(typeof(*((MapType *) NULL)->Entries)) - 1)                   \
+    & ~(alignof(typeof(*((MapType *) NULL)->Entries)) - 1))
+
+#define SWISS_MAP__BlockSize(MapType, Capacity)                                     \
+(SWISS_MAP__EntriesOffset(MapType, Capacity)                                        \
+    + (Capacity) * sizeof(*((MapType *) NULL)->Entries))
+
+#define SWISS_MAP__BlockAlignment(MapType)                                          \
+(alignof(typeof(*((MapType *) NULL)->Entries)) > SWISS_MAP_GROUP_WIDTH              \
+    ? alignof(typeof(*((MapType *) NULL)->Entries))                                 \
+    : SWISS_MAP_GROUP_WIDTH)
+
+#define SwissMap_Free(MapPtr)                                                       \
+do {                                                                                \
+    __auto_type _map_ptr_free = (MapPtr);                                           \
+    if (_map_ptr_free->Capacity > 0) {                                              \
+        Allocator_Free(                                                             \
+            _map_ptr_free->Allocator,                                               \
+            _map_ptr_free->Control,                                                 \
+            SWISS_MAP__BlockSize(typeof(*_map_ptr_free), _map_ptr_free->Capacity)   \
+        );                                                                          \
+    }                                                                               \
+    *_map_ptr_free = SwissMap_WithAllocator(                                        \
+        typeof(*_map_ptr_free),                                                     \
+        _map_ptr_free->Hash,                                                        \
+        _map_ptr_free->KeyEquals,                                                   \
+        _map_ptr_free->Allocator                                                    \
+    );                                                                              \
+} while (0)
+
+// Groups are visited in triangular order (home, +1, +3, +6, ...), which
+// covers every group of a power-of-two sized table. A probe sequence
+// ends at the first group that has an empty slot. Hash_ is the mixed hash
+// of Key_. If FreePtr is not NULL, *FreePtr is set to the first empty or
+// deleted slot of the sequence, or to Capacity if the probe saw none.
+#define SWISS_MAP__Probe(Map_, Key_, Hash_, FreePtr)                                            \
+({                                                                                              \
+    __auto_type _map_probe = (Map_);                                                            \
+    typeof(*(_map_probe.Entries)) *_found_probe = NULL;                                         \
+    size_t *_freePtr_probe = (FreePtr);                                                         \
+    if (NULL != _freePtr_probe) {                                                               \
+        *_freePtr_probe = _map_probe.Capacity;                                                  \
+    }                                                                                           \
+    if (_map_probe.Capacity > 0) {                                                              \
+        typeof(_map_probe.Entries->Key) _key_probe = (Key_);                                    \
+        size_t const _hash_probe = (Hash_);                                                     \
+        size_t const _groupMask_probe = _map_probe.Capacity / SWISS_MAP_GROUP_WIDTH - 1;        \
+        size_t _group_probe = SWISS_MAP__H1(_hash_probe) & _groupMask_probe;                    \
+        for (size_t _step_probe = 1; ; _step_probe++) {                                         \
+            int8_t const *_control_probe =                                                      \
+                _map_probe.Control + _group_probe * SWISS_MAP_GROUP_WIDTH;                      \
+            for (                                                                               \
+                uint32_t _matches_probe =                                                       \
+                    SWISS_MAP__MatchByte(_control_probe, SWISS_MAP__H2(_hash_probe));           \
+                0 != _matches_probe;                                                            \
+                _matches_probe &= _matches_probe - 1                                            \
+            ) {                                                                                 \
+                size_t const _i_probe =                                                         \
+                    _group_probe * SWISS_MAP_GROUP_WIDTH + __builtin_ctz(_matches_probe);       \
+                if (MAP__KeysEqual(_map_probe, _key_probe, _map_probe.Entries[_i_probe].Key)) { \
+                    _found_probe = &(_map_probe.Entries[_i_probe]);                             \
+                    break;                                                                      \
+                }                                                                               \
+            }                                                                                   \
+            if (NULL != _found_probe) {                                                         \
+                break;                                                                          \
+            }                                                                                   \
+            uint32_t const _free_probe = SWISS_MAP__MatchFree(_control_probe);                  \
+            if (                                                                                \
+                NULL != _freePtr_probe                                                          \
+                && _map_probe.Capacity == *_freePtr_probe                                       \
+                && 0 != _free_probe                                                             \
+            ) {                                                                                 \
+                *_freePtr_probe =                                                               \
+                    _group_probe * SWISS_MAP_GROUP_WIDTH + __builtin_ctz(_free_probe);          \
+            }                                                                                   \
+            if (0 != SWISS_MAP__MatchEmpty(_control_probe)) {                                   \
+                break;                                                                          \
+            }                                                                                   \
+            _group_probe = (_group_probe + _step_probe) & _groupMask_probe;                     \
+        }                                                                                       \
+    }                                                                                           \
+    _found_probe;                                                                               \
+})
+
+#define SWISS_MAP__FindWithHash(Map_, Key_, Hash_) SWISS_MAP__Probe((Map_), (Key_), (Hash_), NULL)
+
+#define SWISS_MAP__Find(Map_, Key_)                                                         \
+({                                                                                          \
+    __auto_type _map_find = (Map_);                                                         \
+    typeof(*(_map_find.Entries)) *_found = NULL;                                            \
+    if (_map_find.Capacity > 0) {                                                           \
+        typeof(_map_find.Entries->Key) _key_find = (Key_);                                  \
+        _found = SWISS_MAP__FindWithHash(                                                   \
+            _map_find, _key_find, SWISS_MAP__Mix(MAP__Hash(_map_find, _key_find)));         \
+    }                                                                                       \
+    _found;                                                                                 \
+})
+
+// Store a key with mixed hash Hash_ in the free slot Index.
+#define SWISS_MAP__InsertAt(MapPtr, Index, Key_, Hash_)                                     \
+({                                                                                          \
+    __auto_type _map_ptr_insert_at = (MapPtr);                                              \
+    size_t const _i_insert_at = (Index);                                                    \
+    if (SWISS_MAP__EMPTY == _map_ptr_insert_at->Control[_i_insert_at]) {                    \
+        _map_ptr_insert_at->GrowthLeft -= 1;                                                \
+    }                                                                                       \
+    _map_ptr_insert_at->Control[_i_insert_at] = SWISS_MAP__H2(Hash_);                       \
+    _map_ptr_insert_at->Entries[_i_insert_at].Key = (Key_);                                 \
+    _map_ptr_insert_at->Size += 1;                                                          \
+    &(_map_ptr_insert_at->Entries[_i_insert_at]);                                           \
+})
+
+// Insert a key that is known to be absent, with mixed hash Hash_, into the
+// first empty or deleted slot of its probe sequence; the map must have
+// GrowthLeft > 0. Return a pointer to the new entry, whose value is left
+// uninitialized.
+#define SWISS_MAP__InsertWithHash(MapPtr, Key_, Hash_)                                      \
+({                                                                                          \
+    __auto_type _map_ptr_insert = (MapPtr);                                                 \
+    size_t const _hash_insert = (Hash_);                                                    \
+    size_t const _groupMask_insert = _map_ptr_insert->Capacity / SWISS_MAP_GROUP_WIDTH - 1; \
+    size_t _group_insert = SWISS_MAP__H1(_hash_insert) & _groupMask_insert;                 \
+    uint32_t _free_insert;                                                                  \
+    for (size_t _step_insert = 1; ; _step_insert++) {                                       \
+        _free_insert = SWISS_MAP__MatchFree(                                                \
+            _map_ptr_insert->Control + _group_insert * SWISS_MAP_GROUP_WIDTH);              \
+        if (0 != _free_insert) {                                                            \
+            break;                                                                          \
+        }                                                                                   \
+        _group_insert = (_group_insert + _step_insert) & _groupMask_insert;                 \
+    }                                                                                       \
+    SWISS_MAP__InsertAt(                                                                    \
+        _map_ptr_insert,                                                                    \
+        _group_insert * SWISS_MAP_GROUP_WIDTH + __builtin_ctz(_free_insert),                \
+        (Key_), _hash_insert);                                                              \
+})
+
+#define SWISS_MAP__Insert(MapPtr, Key_)                                                                  \
+({                                                                                                       \
+    __auto_type _map_ptr_insert_key = (MapPtr);                                                          \
+    typeof(_map_ptr_insert_key->Entries->Key) _key_insert = (Key_);                                      \
+    SWISS_MAP__InsertWithHash(                                                                           \
+        _map_ptr_insert_key, _key_insert, SWISS_MAP__Mix(MAP__Hash(*_map_ptr_insert_key, _key_insert))); \
+})
+
+// Rebuild the table with NewCapacity slots, dropping all tombstones.
+#define SWISS_MAP__Resize(MapPtr, NewCapacity)                                              \
+do {                                                                                        \
+    __auto_type _map_ptr_resize = (MapPtr);                                                 \
+    typedef typeof(*_map_ptr_resize) _MapType_resize;                                       \
+    _MapType_resize const _old_resize = *_map_ptr_resize;                                   \
+    size_t const _newCapacity_resize = (NewCapacity);                                       \
+    void *_block_resize = SWISS_MAP__CallChecked(Allocator_Allocate, (                      \
+        _map_ptr_resize->Allocator,                                                         \
+        SWISS_MAP__BlockSize(_MapType_resize, _newCapacity_resize),                         \
+        SWISS_MAP__BlockAlignment(_MapType_resize)                                          \
+    ));                                                                                     \
+    memset(_block_resize, (uint8_t) SWISS_MAP__EMPTY, _newCapacity_resize);                 \
+    _map_ptr_resize->Control = _block_resize;                                               \
+    _map_ptr_resize->Entries = (void *) ((char *) _block_resize                             \
+        + SWISS_MAP__EntriesOffset(_MapType_resize, _newCapacity_resize));                  \
+    _map_ptr_resize->Capacity = _newCapacity_resize;                                        \
+    _map_ptr_resize->GrowthLeft = _newCapacity_resize - _newCapacity_resize / 8;            \
+    _map_ptr_resize->Size = 0;                                                              \
+                                                                                            \
+    for (size_t _i_resize = 0; _i_resize < _old_resize.Capacity; _i_resize++) {             \
+        if (_old_resize.Control[_i_resize] < 0) {                                           \
+            continue;                                                                       \
+        }                                                                                   \
+        SWISS_MAP__Insert(_map_ptr_resize, _old_resize.Entries[_i_resize].Key)->Value =     \
+            _old_resize.Entries[_i_resize].Value;                                           \
+    }                                                                                       \
+                                                                                            \
+    if (_old_resize.Capacity > 0) {                                                         \
+        Allocator_Free(                                                                     \
+            _map_ptr_resize->Allocator,                                                     \
+            _old_resize.Control,                                                            \
+            SWISS_MAP__BlockSize(_MapType_resize, _old_resize.Capacity)                     \
+        );                                                                                  \
+    }                                                                                       \
+} while (0)
+
+// Called when no free slot is left under the 7/8 load limit. If
+// tombstones take up a large part of the table, rebuilding it at the same
+// capacity is enough; otherwise the capacity is doubled.
+#define SWISS_MAP__Grow(MapPtr)                                                    \
+do {                                                                               \
+    __auto_type _map_ptr_grow = (MapPtr);                                          \
+    size_t const _capacity_grow = _map_ptr_grow->Capacity;                         \
+    SWISS_MAP__Resize(                                                             \
+        _map_ptr_grow,                                                             \
+        0 == _capacity_grow                                                        \
+            ? SWISS_MAP_GROUP_WIDTH                                                \
+            : 2 * (_map_ptr_grow->Size + 1) <= _capacity_grow - _capacity_grow / 8 \
+                ? _capacity_grow                                                   \
+                : 2 * _capacity_grow                                               \
+    );                                                                             \
+} while (0)
+
+// Return a pointer to the entry with Key_, inserting one with an
+// uninitialized value if the key is absent, and set *InsertedPtr to
+// whether it did. The key is hashed once, and a single probe both looks
+// for it and finds the slot to insert into, unless the table has to grow
+// first.
+#define SWISS_MAP__Upsert(MapPtr, Key_, InsertedPtr)                                        \
+({                                                                                          \
+    __auto_type _map_ptr_upsert = (MapPtr);                                                 \
+    typeof(_map_ptr_upsert->Entries->Key) _key_upsert = (Key_);                             \
+    size_t const _hash_upsert = SWISS_MAP__Mix(MAP__Hash(*_map_ptr_upsert, _key_upsert));   \
+    size_t _free_upsert;                                                                    \
+    __auto_type _slot_upsert = SWISS_MAP__Probe(                                            \
+        *_map_ptr_upsert, _key_upsert, _hash_upsert, &_free_upsert);                        \
+    *(InsertedPtr) = NULL == _slot_upsert;                                                  \
+    if (NULL == _slot_upsert) {                                                             \
+        if (                                                                                \
+            _free_upsert < _map_ptr_upsert->Capacity                                        \
+            && (0 != _map_ptr_upsert->GrowthLeft                                            \
+                || SWISS_MAP__DELETED == _map_ptr_upsert->Control[_free_upsert])            \
+        ) {                                                                                 \
+            _slot_upsert = SWISS_MAP__InsertAt(                                             \
+                _map_ptr_upsert, _free_upsert, _key_upsert, _hash_upsert);                  \
+        } else {                                                                            \
+            SWISS_MAP__Grow(_map_ptr_upsert);                                               \
+            _slot_upsert = SWISS_MAP__InsertWithHash(                                       \
+                _map_ptr_upsert, _key_upsert, _hash_upsert);                                \
+        }                                                                                   \
+    }                                                                                       \
+    _slot_upsert;                                                                           \
+})
+
+#define SwissMap_Put(MapPtr, Key_, Value_)                              \
+({                                                                      \
+    bool _inserted_put;                                                 \
+    __auto_type _slot_put =                                             \
+        SWISS_MAP__Upsert((MapPtr), (Key_), &_inserted_put);            \
+    _slot_put->Value = (Value_);                                        \
+    &(_slot_put->Value);                                                \
+})
+
+#define SwissMap_TryPut(MapPtr, Key_, Value_)                                   \
+({                                                                              \
+    bool _inserted_try_put;                                                     \
+    __auto_type _slot_try_put =                                                 \
+        SWISS_MAP__Upsert((MapPtr), (Key_), &_inserted_try_put);                \
+    if (_inserted_try_put) {                                                    \
+        _slot_try_put->Value = (Value_);                                        \
+    }                                                                           \
+    _inserted_try_put;                                                          \
+})
+
+#define SwissMap_GetOrInsert(MapPtr, Key_, DefaultExpr)                         \
+({                                                                              \
+    bool _inserted_get_or_insert;                                               \
+    __auto_type _slot_get_or_insert =                                           \
+        SWISS_MAP__Upsert((MapPtr), (Key_), &_inserted_get_or_insert);          \
+    if (_inserted_get_or_insert) {                                              \
+        _slot_get_or_insert->Value = (DefaultExpr);                             \
+    }                                                                           \
+    (struct { typeof(_slot_get_or_insert->Value) *Value; bool Inserted; }) {    \
+        .Value = &(_slot_get_or_insert->Value),                                 \
+        .Inserted = _inserted_get_or_insert,                                    \
+    };                                                                          \
+})
+
+#define SwissMap_At(Map_, Key_)                                 \
+({                                                              \
+    __auto_type _slot_at = SWISS_MAP__Find((Map_), (Key_));     \
+    (NULL == _slot_at ? NULL : &_slot_at->Value);               \
+})
+
+#define SwissMap_TryGet(Map_, Key_, ValuePtr)                   \
+({                                                              \
+    __auto_type _value_try_get = SwissMap_At((Map_), (Key_));   \
+    if (NULL != _value_try_get) {                               \
+        *ValuePtr = *_value_try_get;                            \
+    }                                                           \
+    NULL != _value_try_get;                                     \
+})
+
+#define SwissMap_GetOrDefault(Map_, Key_, DefaultExpr)                  \
+({                                                                      \
+    typeof((Map_).Entries->Value) _value_or_default;                    \
+    if (false == SwissMap_TryGet((Map_), (Key_), &_value_or_default)) { \
+        _value_or_default = (DefaultExpr);                              \
+    }                                                                   \
+    _value_or_default;                                                  \
+})
+
+// A probe sequence only moves past a group that has no empty slot, so a
+// removed slot can be marked empty again if its group still has one.
+// Otherwise it becomes a tombstone, which is reused by later insertions
+// and dropped when the table is rebuilt.
+#define SwissMap_Remove(MapPtr, Key_)                                               \
+({                                                                                  \
+    __auto_type _map_ptr_remove = (MapPtr);                                         \
+    __auto_type _slot_remove = SWISS_MAP__Find(*_map_ptr_remove, (Key_));           \
+    if (NULL != _slot_remove) {                                                     \
+        size_t const _i_remove = _slot_remove - _map_ptr_remove->Entries;           \
+        int8_t const *_group_remove = _map_ptr_remove->Control                      \
+            + _i_remove / SWISS_MAP_GROUP_WIDTH * SWISS_MAP_GROUP_WIDTH;            \
+        if (0 != SWISS_MAP__MatchEmpty(_group_remove)) {                            \
+            _map_ptr_remove->Control[_i_remove] = SWISS_MAP__EMPTY;                 \
+            _map_ptr_remove->GrowthLeft += 1;                                       \
+        } else {                                                                    \
+            _map_ptr_remove->Control[_i_remove] = SWISS_MAP__DELETED;               \
+        }                                                                           \
+        _map_ptr_remove->Size -= 1;                                                 \
+    }                                                                               \
+    NULL != _slot_remove;                                                           \
+})
+
+#define SWISS_MAP__TryFindNextFullIndex(Map_, BaseIndex, NextIndexPtr)  \
+({                                                                      \
+    __auto_type _map_try_find_next_index = (Map_);                      \
+    size_t _i_next = (BaseIndex);                                       \
+    bool _ok = false;                                                   \
+    for (; _i_next < _map_try_find_next_index.Capacity; _i_next++) {    \
+        if (_map_try_find_next_index.Control[_i_next] < 0) {            \
+            continue;                                                   \
+        }                                                               \
+        *(NextIndexPtr) = _i_next;                                      \
+        _ok = true;                                                     \
+        break;                                                          \
+    }                                                                   \
+     _ok;                                                               \
+})
+
+#define SwissMap_ForEach(EntryPtr, Map_)                                                               \
+size_t SWISS_MAP__Concat(_i_, __LINE__) = 0;                                                           \
+__auto_type SWISS_MAP__Concat(_map_for_each_, __LINE__) = (Map_);                                      \
+for (                                                                                                  \
+    typeof(*(SWISS_MAP__Concat(_map_for_each_, __LINE__).Entries)) *EntryPtr =                         \
+        SWISS_MAP__TryFindNextFullIndex(                                                               \
+            SWISS_MAP__Concat(_map_for_each_, __LINE__),                                               \
+            SWISS_MAP__Concat(_i_, __LINE__),                                                          \
+            &SWISS_MAP__Concat(_i_, __LINE__)                                                          \
+        )                                                                                              \
+            ? &(SWISS_MAP__Concat(_map_for_each_, __LINE__).Entries[SWISS_MAP__Concat(_i_, __LINE__)]) \
+            : NULL;                                                                                    \
+    NULL != EntryPtr;                                                                                  \
+    EntryPtr =                                                                                         \
+        SWISS_MAP__TryFindNextFullIndex(                                                               \
+            SWISS_MAP__Concat(_map_for_each_, __LINE__),                                               \
+            SWISS_MAP__Concat(_i_, __LINE__) + 1,                                                      \
+            &SWISS_MAP__Concat(_i_, __LINE__)                                                          \
+        )                                                                                              \
+            ? &(SWISS_MAP__Concat(_map_for_each_, __LINE__).Entries[SWISS_MAP__Concat(_i_, __LINE__)]) \
+            : NULL                                                                                     \
+)
+
+#define SwissMap_IsEmpty(Map_) (0 == (Map_).Size)
+
+#endif // SWISS_MAP_H
@@ -0,0 +1,343 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "swiss_map.h"
+
+#include "testing/testing.h"
+
+typedef SwissMap(int, int) IntIntMap;
+typedef SwissMap(char const *, int) StringIntMap;
+
+size_t StrHash(char const *s) {
+    unsigned long hash = 5381;
+    int c;
+
+    while ('\0' != (c = (unsigned char) *s++)) {
+        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+    }
+
+    return hash;
+}
+
+bool StrEquals(char const *s1, char const *s2) {
+    return 0 == strcmp(s1, s2);
+}
+
+size_t IntHashIdentity(int value) {
+    return (size_t) value;
+}
+
+size_t IntHashConst(int unused) {
+    (void) unused;
+    return 42;
+}
+
+bool IntEquals(int a, int b) { return a == b; }
+
+static size_t StrHashCalls = 0;
+
+size_t CountingStrHash(char const *s) {
+    StrHashCalls++;
+    return StrHash(s);
+}
+
+Testing_Fact(Empty_returns_map_with_Size_set_to_0) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    Testing_Assert(0 == sut.Size, "expected size to be 0 but was %zu", sut.Size);
+    Testing_Assert(true == SwissMap_IsEmpty(sut), "expected IsEmpty to return true");
+    Testing_Assert(NULL == SwissMap_At(sut, 1), "expected At to return NULL for empty map");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Put_associates_key_with_value) {
+    StringIntMap sut = SwissMap_Empty(StringIntMap, StrHash, StrEquals);
+
+    char const *keys[] = {"one", "two", "three", "four", "five"};
+    size_t const keysCount = sizeof(keys) / sizeof(keys[0]);
+    for (size_t i = 0; i < keysCount; i++) {
+        SwissMap_Put(&sut, keys[i], (int) i + 1);
+    }
+
+    Testing_Assert(keysCount == sut.Size, "expected size to be %zu but was %zu", keysCount, sut.Size);
+    for (size_t i = 0; i < keysCount; i++) {
+        int value;
+        Testing_Assert(SwissMap_TryGet(sut, keys[i], &value), "expected key %s to be found", keys[i]);
+        Testing_Assert((int) i + 1 == value, "expected value %zu at key %s but got %d", i + 1, keys[i], value);
+    }
+    Testing_Assert(NULL == SwissMap_At(sut, "six"), "expected missing key to not be found");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Put_overwrites_values_if_called_with_same_key) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    SwissMap_Put(&sut, 3, 9);
+    int *value = SwissMap_Put(&sut, 3, 27);
+
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+    Testing_Assert(27 == *value, "expected Put to return pointer to the new value");
+    Testing_Assert(27 == SwissMap_GetOrDefault(sut, 3, -1), "expected value to be overwritten");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Put_handles_collisions_with_constant_hash) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashConst, IntEquals);
+
+    int const keysCount = 100;
+    for (int i = 0; i < keysCount; i++) {
+        SwissMap_Put(&sut, i, -i);
+    }
+
+    for (int i = 0; i < keysCount; i++) {
+        int const value = SwissMap_GetOrDefault(sut, i, 1);
+        Testing_Assert(-i == value, "expected value %d at key %d but got %d", -i, i, value);
+    }
+    Testing_Assert(1 == SwissMap_GetOrDefault(sut, keysCount, 1), "expected missing key to not be found");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Put_keeps_load_factor_under_seven_eighths) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    for (int i = 0; i < 5000; i++) {
+        SwissMap_Put(&sut, i, i);
+        Testing_Assert(
+            8 * sut.Size <= 7 * sut.Capacity,
+            "expected at most 7/8 of %zu slots to be used but got %zu", sut.Capacity, sut.Size);
+        Testing_Assert(
+            0 == (sut.Capacity & (sut.Capacity - 1)) && sut.Capacity >= SWISS_MAP_GROUP_WIDTH,
+            "expected capacity to be a power of two but was %zu", sut.Capacity);
+    }
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(GetOrDefault_only_evaluates_default_expression_if_key_does_not_exist) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    SwissMap_Put(&sut, 1, 1);
+
+    int evaluated = 0;
+    SwissMap_GetOrDefault(sut, 1, ++evaluated);
+    Testing_Assert(0 == evaluated, "expected default to not be evaluated for existing key");
+
+    SwissMap_GetOrDefault(sut, 2, ++evaluated);
+    Testing_Assert(1 == evaluated, "expected default to be evaluated for missing key");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Remove_deletes_key_and_decreases_size) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    Testing_Assert(false == SwissMap_Remove(&sut, 1), "expected Remove to return false for empty map");
+
+    SwissMap_Put(&sut, 1, 1);
+    SwissMap_Put(&sut, 2, 4);
+
+    Testing_Assert(true == SwissMap_Remove(&sut, 1), "expected Remove to return true for existing key");
+    Testing_Assert(false == SwissMap_Remove(&sut, 1), "expected Remove to return false for removed key");
+    Testing_Assert(1 == sut.Size, "expected size to be 1 but was %zu", sut.Size);
+    Testing_Assert(NULL == SwissMap_At(sut, 1), "expected removed key to not be found");
+    Testing_Assert(4 == SwissMap_GetOrDefault(sut, 2, -1), "expected other keys to be kept");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Remove_keeps_colliding_keys_reachable) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashConst, IntEquals);
+
+    int const keysCount = 60;
+    for (int i = 0; i < keysCount; i++) {
+        SwissMap_Put(&sut, i, i * i);
+    }
+
+    for (int i = 0; i < keysCount; i += 3) {
+        Testing_Assert(true == SwissMap_Remove(&sut, i), "expected key %d to be removed", i);
+    }
+
+    for (int i = 0; i < keysCount; i++) {
+        int value;
+        bool const found = SwissMap_TryGet(sut, i, &value);
+        if (0 == i % 3) {
+            Testing_Assert(false == found, "expected key %d to be removed", i);
+        } else {
+            Testing_Assert(found, "expected key %d to be found", i);
+            Testing_Assert(i * i == value, "expected value %d at key %d but got %d", i * i, i, value);
+        }
+    }
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Remove_reuses_slots_without_growing_under_churn) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    bool present[256] = {0};
+    size_t expectedSize = 0;
+    unsigned state = 12345;
+    for (int step = 0; step < 50000; step++) {
+        state = state * 1103515245 + 12345;
+        int const key = (int) ((state >> 8) % 256);
+        if (state & 1) {
+            expectedSize += false == present[key];
+            present[key] = true;
+            SwissMap_Put(&sut, key, key);
+        } else {
+            expectedSize -= present[key];
+            Testing_Assert(present[key] == SwissMap_Remove(&sut, key), "unexpected Remove result for key %d", key);
+            present[key] = false;
+        }
+    }
+
+    Testing_Assert(expectedSize == sut.Size, "expected size to be %zu but was %zu", expectedSize, sut.Size);
+    Testing_Assert(sut.Capacity <= 512, "expected capacity to stay bounded but was %zu", sut.Capacity);
+    for (int key = 0; key < 256; key++) {
+        Testing_Assert(present[key] == (NULL != SwissMap_At(sut, key)), "unexpected presence of key %d", key);
+    }
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Put_hashes_new_and_existing_keys_once) {
+    StringIntMap sut = SwissMap_Empty(StringIntMap, CountingStrHash, StrEquals);
+    SwissMap_Put(&sut, "one", 1);
+
+    StrHashCalls = 0;
+    SwissMap_Put(&sut, "two", 2);
+    Testing_Assert(1 == StrHashCalls, "expected one Hash call for new key but got %zu", StrHashCalls);
+
+    StrHashCalls = 0;
+    SwissMap_Put(&sut, "one", 11);
+    Testing_Assert(1 == StrHashCalls, "expected one Hash call for existing key but got %zu", StrHashCalls);
+    Testing_Assert(11 == SwissMap_GetOrDefault(sut, "one", -1), "expected value to be overwritten");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(TryPut_only_inserts_absent_keys) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashConst, IntEquals);
+
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(SwissMap_TryPut(&sut, i, i), "expected key %d to be inserted", i);
+    }
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(false == SwissMap_TryPut(&sut, i, -1), "expected key %d to be kept", i);
+        Testing_Assert(i == SwissMap_GetOrDefault(sut, i, -1), "expected value %d at key %d", i, i);
+    }
+    Testing_Assert(100 == sut.Size, "expected size to be 100 but was %zu", sut.Size);
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(GetOrInsert_evaluates_default_only_for_absent_key) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    int evaluations = 0;
+
+    __auto_type inserted = SwissMap_GetOrInsert(&sut, 1, (evaluations++, 10));
+    Testing_Assert(inserted.Inserted && 10 == *inserted.Value, "expected new entry with default value");
+    *inserted.Value += 1;
+
+    __auto_type existing = SwissMap_GetOrInsert(&sut, 1, (evaluations++, 20));
+    Testing_Assert(false == existing.Inserted, "expected existing entry to be returned");
+    Testing_Assert(11 == *existing.Value, "expected value 11 but got %d", *existing.Value);
+    Testing_Assert(1 == evaluations, "expected default to be evaluated once but was %d times", evaluations);
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Empty_with_NULL_functions_uses_defaults_for_key_type) {
+    IntIntMap ints = SwissMap_Empty(IntIntMap, NULL, NULL);
+    StringIntMap strings = SwissMap_Empty(StringIntMap, NULL, NULL);
+    for (int i = 0; i < 100; i++) {
+        SwissMap_Put(&ints, i, -i);
+    }
+    SwissMap_Put(&strings, "one", 1);
+
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(-i == SwissMap_GetOrDefault(ints, i, 1), "expected value %d at key %d", -i, i);
+    }
+    char key[] = "one";
+    Testing_Assert(1 == SwissMap_GetOrDefault(strings, key, -1), "expected keys to be compared by contents");
+    Testing_Assert(SwissMap_Remove(&strings, key), "expected key to be removed");
+
+    SwissMap_Free(&ints);
+    SwissMap_Free(&strings);
+}
+
+Testing_Fact(ForEach_iterates_over_all_elements) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    size_t const keysCount = 40;
+    for (size_t i = 0; i < keysCount; i++) {
+        SwissMap_Put(&sut, (int) i, (int) (2 * i));
+    }
+    SwissMap_Remove(&sut, 0);
+
+    bool visited[keysCount];
+    memset(visited, 0x00, sizeof(visited));
+    size_t visitedCount = 0;
+    SwissMap_ForEach(entry, sut) {
+        Testing_Assert(entry->Key > 0 && entry->Key < (int) keysCount, "unexpected key %d", entry->Key);
+        Testing_Assert(2 * entry->Key == entry->Value, "wrong value at key %d", entry->Key);
+        Testing_Assert(false == visited[entry->Key], "expected key %d to not be visited already", entry->Key);
+        visited[entry->Key] = true;
+        visitedCount++;
+    }
+
+    Testing_Assert(keysCount - 1 == visitedCount, "expected ForEach to visit %zu keys but visited %zu", keysCount - 1, visitedCount);
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(ForEach_never_executes_body_for_empty_map) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+
+    SwissMap_ForEach(entry, sut) {
+        Testing_Assert(false, "expected body to never be executed");
+    }
+
+    SwissMap_Free(&sut);
+}
+
+Testing_Fact(Free_resets_map_and_keeps_functions) {
+    IntIntMap sut = SwissMap_Empty(IntIntMap, IntHashIdentity, IntEquals);
+    SwissMap_Put(&sut, 1, 1);
+
+    SwissMap_Free(&sut);
+
+    Testing_Assert(0 == sut.Size && 0 == sut.Capacity, "expected map to be empty");
+    Testing_Assert(IntHashIdentity == sut.Hash, "expected hash function to be kept");
+    Testing_Assert(IntEquals == sut.KeyEquals, "expected equality function to be kept");
+
+    SwissMap_Put(&sut, 2, 2);
+    Testing_Assert(2 == SwissMap_GetOrDefault(sut, 2, -1), "expected map to be usable after Free");
+
+    SwissMap_Free(&sut);
+}
+
+Testing_AllTests = {
+        Testing_AddTest(Empty_returns_map_with_Size_set_to_0),
+        Testing_AddTest(Put_associates_key_with_value),
+        Testing_AddTest(Put_overwrites_values_if_called_with_same_key),
+        Testing_AddTest(Put_handles_collisions_with_constant_hash),
+        Testing_AddTest(Put_keeps_load_factor_under_seven_eighths),
+        Testing_AddTest(GetOrDefault_only_evaluates_default_expression_if_key_does_not_exist),
+        Testing_AddTest(Remove_deletes_key_and_decreases_size),
+        Testing_AddTest(Remove_keeps_colliding_keys_reachable),
+        Testing_AddTest(Remove_reuses_slots_without_growing_under_churn),
+        Testing_AddTest(Put_hashes_new_and_existing_keys_once),
+        Testing_AddTest(TryPut_only_inserts_absent_keys),
+        Testing_AddTest(GetOrInsert_evaluates_default_only_for_absent_key),
+        Testing_AddTest(Empty_with_NULL_functions_uses_defaults_for_key_type),
+        Testing_AddTest(ForEach_iterates_over_all_elements),
+        Testing_AddTest(ForEach_never_executes_body_for_empty_map),
+        Testing_AddTest(Free_resets_map_and_keeps_functions),
+};
+
+Testing_RunAllTests();
@@ -1,9 +1,14 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdalign.h>
+
+#include "../allocators/allocator.h"
 
 #define VECTOR__ArrayLength(Array)      (sizeof(Array) / sizeof(*(Array)))
 #define VECTOR__ToArrayLiteral(_0, ...) ((typeof(_0)[]) {_0, ##__VA_ARGS__})
@@ -24,15 +29,18 @@
     _r;                                     \
 })
 
-#define Vector(TValue)  \
-struct {                \
-    size_t Size;        \
-    size_t Capacity;    \
-    TValue *Items;      \
+#define Vector(TValue)      \
+struct {                    \
+    size_t Size;            \
+    size_t Capacity;        \
+    TValue *Items;          \
+    Allocator Allocator;    \
 }
 
 #define Vector_Empty(VectorType) ((VectorType) {0})
 
+#define Vector_WithAllocator(VectorType, Allocator_) ((VectorType) {.Allocator = (Allocator_)})
+
 #define Vector_FromPtr(VectorType, Ptr, Count)                          \
 ({                                                                      \
     __auto_type _vec_fromArray = Vector_Empty(VectorType);              \
@@ -56,10 +64,18 @@ struct {                \
 
 #define Vector_Of(VectorType, ...) Vector_FromArray(VectorType, VECTOR__ToArrayLiteral(__VA_ARGS__))
 
-#define Vector_Free(VecPtr)                 \
-do {                                        \
-    free((void *) (VecPtr)->Items);         \
-    *(VecPtr) = (typeof(*(VecPtr))) { 0 };  \
+#define Vector_Free(VecPtr)                                                 \
+do {                                                                        \
+    __auto_type _vecPtr_free = (VecPtr);                                    \
+    Allocator_Free(                                                         \
+        _vecPtr_free->Allocator,                                            \
+        (void *) _vecPtr_free->Items,                                       \
+        _vecPtr_free->Capacity * sizeof(_vecPtr_free->Items[0])             \
+    );                                                                      \
+    *_vecPtr_free = Vector_WithAllocator(                                   \
+        typeof(*_vecPtr_free),                                              \
+        _vecPtr_free->Allocator                                             \
+    );                                                                      \
 } while (0)
 
 #define Vector_Reserve(VecPtr, NewCapacity)                             \
@@ -69,12 +85,15 @@ do {                                                                    \
     if (_newCapacity <= _vecPtr_reserve->Capacity) {                    \
         break;                                                          \
     }                                                                   \
-    _vecPtr_reserve->Capacity = _newCapacity;                           \
-    __auto_type _items = VECTOR__CallChecked(realloc, (                 \
+    __auto_type _items = VECTOR__CallChecked(Allocator_Reallocate, (    \
+        _vecPtr_reserve->Allocator,                                     \
         (void *) _vecPtr_reserve->Items,                                \
-        _vecPtr_reserve->Capacity * sizeof(_vecPtr_reserve->Items[0])   \
+        _vecPtr_reserve->Capacity * sizeof(_vecPtr_reserve->Items[0]),  \
+        _newCapacity * sizeof(_vecPtr_reserve->Items[0]),               \
+        alignof(typeof(_vecPtr_reserve->Items[0]))                      \
     ));                                                                 \
     _vecPtr_reserve->Items = _items;                                    \
+    _vecPtr_reserve->Capacity = _newCapacity;                           \
 } while (0)
 
 #define Vector_PushBack(VecPtr, Val)                                        \
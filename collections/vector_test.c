@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "vector.h"
 
@@ -278,6 +279,22 @@ Testing_Fact(At_returns_NULL_for_invalid_index) {
     Testing_Assert(NULL == Vector_At(sut, -42), "expected NULL for out of bounds index");
 }
 
+Testing_Fact(Reserve_keeps_over_aligned_elements_aligned) {
+    typedef struct { alignas(64) int Value; } AlignedInt;
+    typedef Vector(AlignedInt) AlignedIntVector;
+    AlignedIntVector sut = Vector_Empty(AlignedIntVector);
+
+    for (int i = 0; i < 100; i++) {
+        Vector_PushBack(&sut, ((AlignedInt) {.Value = i}));
+        Testing_Assert(0 == (uintptr_t) sut.Items % 64, "expected items to be 64-byte aligned");
+    }
+    for (int i = 0; i < 100; i++) {
+        Testing_Assert(i == sut.Items[i].Value, "expected %d at index %d", i, i);
+    }
+
+    Vector_Free(&sut);
+}
+
 Testing_AllTests = {
         Testing_AddTest(Empty_returns_vector_with_Size_and_Capacity_set_to_0),
         Testing_AddTest(FromPtr_returns_vector_with_elements_from_given_address),
@@ -302,6 +319,7 @@ Testing_AllTests = {
         Testing_AddTest(At_returns_pointer_to_element_for_valid_positive_index),
         Testing_AddTest(At_returns_pointer_to_element_for_valid_negative_index),
         Testing_AddTest(At_returns_NULL_for_invalid_index),
+        Testing_AddTest(Reserve_keeps_over_aligned_elements_aligned),
 };
 
 Testing_RunAllTests();
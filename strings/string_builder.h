@@ -4,15 +4,20 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include "../allocators/allocator.h"
+
 typedef struct StringBuilder StringBuilder;
 struct StringBuilder {
     char *Chars;
     size_t CurrentLength;
     size_t MaxLength;
+    Allocator Allocator;
 };
 
 #define StringBuilder_Empty() ((StringBuilder) {0})
 
+#define StringBuilder_WithAllocator(Allocator_) ((StringBuilder) {.Allocator = (Allocator_)})
+
 void StringBuilder_Free(StringBuilder *);
 
 void StringBuilder_Sprintf(StringBuilder builder[static 1], char const *format, ...);
@@ -32,6 +37,7 @@ char *StringBuilder_ToCStr(StringBuilder builder);
 #include <string.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <stdalign.h>
 
 #define STRING_BUILDER__CallChecked(Callee, ArgsList)    \
 ({                                          \
@@ -52,8 +58,10 @@ char *StringBuilder_ToCStr(StringBuilder builder);
 void StringBuilder_Free(StringBuilder *builder) {
     if (NULL == builder) { return; }
 
-    free(builder->Chars);
-    *builder = StringBuilder_Empty();
+    if (NULL != builder->Chars) {
+        Allocator_Free(builder->Allocator, builder->Chars, (1 + builder->MaxLength) * sizeof(char));
+    }
+    *builder = StringBuilder_WithAllocator(builder->Allocator);
 }
 
 void STRING_BUILDER__ReserveToFit(StringBuilder builder[static 1], size_t strLen) {
@@ -61,8 +69,11 @@ void STRING_BUILDER__ReserveToFit(StringBuilder builder[static 1], size_t strLen
     if (newMaxLen <= builder->MaxLength) {
         return;
     }
-    builder->Chars =
-            STRING_BUILDER__CallChecked(realloc, (builder->Chars, (1 + newMaxLen) * sizeof(char)));
+    size_t const oldSize = NULL != builder->Chars ? (1 + builder->MaxLength) * sizeof(char) : 0;
+    builder->Chars = STRING_BUILDER__CallChecked(
+            Allocator_Reallocate,
+            (builder->Allocator, builder->Chars, oldSize, (1 + newMaxLen) * sizeof(char), alignof(char))
+    );
     builder->MaxLength = newMaxLen;
 }
 